@@ -2,9 +2,12 @@
 // Copyright(c) 2017 Intel Corporation. All Rights Reserved.
 
 #include <librealsense2/rs.hpp> // Include RealSense Cross Platform API
+#include <librealsense2/rsutil.h>
 #include <opencv2/opencv.hpp>   // Include OpenCV API
 #include <vector>
 #include <string>
+#include "app-steps.hpp"
+#include "trajectory-store.hpp"
 
 using namespace std;
 using namespace cv;
@@ -47,6 +50,10 @@ void mouse_callback(int event, int x, int y, int flags, void* userdata)
 }
 
 
+// Usage: 2021-03-16 [--trajectory-log PATH]
+//
+// The target history is appended to PATH, by default
+// trajectory-<date>-<time>.log in the working directory.
 int main(int argc, char* argv[]) try
 {
     // Declare depth colorizer for pretty visualization of depth data
@@ -64,6 +71,10 @@ int main(int argc, char* argv[]) try
 
     Rect2d bbox;
 
+    // Keep every measurement instead of only drawing it
+    trajectory_store trajectories;
+    trajectory_log trajectory_file(trajectory_log_path(argc, argv));
+
     while (waitKey(1) < 0 && getWindowProperty(window_name, WND_PROP_AUTOSIZE) >= 0)
     {
         rs2::frameset data = pipe.wait_for_frames(); // Wait for next set of frames from the camera
@@ -105,7 +116,26 @@ int main(int argc, char* argv[]) try
         float dist_to_width = bbox.x + (bbox.width / 2);
         float dist_to_height = bbox.y + (bbox.height / 2);
 
-        float dist_to_center = depth.get_distance(dist_to_width, dist_to_height) * 100;
+        // Shared with tracking_regression (app-steps.hpp)
+        float dist_to_center = center_distance(depth, bbox) * 100;
+
+        if (bbox.area() > 0)
+        {
+            auto intrin = depth.get_profile().as<rs2::video_stream_profile>().get_intrinsics();
+            float pixel[2] = { dist_to_width, dist_to_height };
+
+            trajectory_record history;
+            history.timestamp = depth.get_timestamp();
+            history.id = 0;
+            history.bbox[0] = bbox.x;
+            history.bbox[1] = bbox.y;
+            history.bbox[2] = bbox.width;
+            history.bbox[3] = bbox.height;
+            rs2_deproject_pixel_to_point(history.position, &intrin, pixel, dist_to_center / 100);
+            history.confidence = dist_to_center > 0 ? 1.f : 0.f;   // 0: no depth at the center
+            trajectories.append(history);
+            trajectory_file.push(history);
+        }
 
         //printf("%.2f\n", dist_to_center);
 
@@ -0,0 +1,226 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+
+#pragma once
+
+#include <librealsense2/rs.hpp> // Include RealSense Cross Platform API
+#include <opencv2/opencv.hpp>   // Include OpenCV API
+#include <opencv2/dnn.hpp>
+#include <opencv4/opencv2/tracking/tracker.hpp>
+#include <algorithm>
+#include <vector>
+#include "cv-helpers.hpp"
+#include "dnn-model.hpp"
+#include "change-detector.hpp"
+#include "stream-profile.hpp"
+
+// Per-frame processing of the apps, shared with tracking_regression so the
+// harness measures exactly what the apps run. Each app keeps its capture,
+// drawing and UI; everything between "frames arrived" and "boxes and
+// distances known" lives here.
+//
+//   goturn_step        tracker.cpp
+//   ssd_step           rect.cpp
+//   center_distance    2021-03-16.cpp
+
+
+// Median depth over the inner half of the box; holes (0 m) are ignored, so a
+// few background or missing pixels do not move the estimate.
+static float robust_depth(const cv::Mat& depth_meters, const cv::Rect2d& box)
+{
+    cv::Rect inner(cvRound(box.x + box.width / 4), cvRound(box.y + box.height / 4),
+        cvRound(box.width / 2), cvRound(box.height / 2));
+    inner &= cv::Rect(0, 0, depth_meters.cols, depth_meters.rows);
+
+    std::vector<double> values;
+    values.reserve(inner.area());
+    for (int y = inner.y; y < inner.y + inner.height; y++)
+    {
+        const double* row = depth_meters.ptr<double>(y);
+        for (int x = inner.x; x < inner.x + inner.width; x++)
+            if (row[x] > 0) values.push_back(row[x]);
+    }
+
+    if (values.empty()) return 0.f;
+
+    auto mid = values.begin() + values.size() / 2;
+    std::nth_element(values.begin(), mid, values.end());
+    return static_cast<float>(*mid);
+}
+
+
+// GOTURN on the color image resized to the depth resolution. Color is
+// captured as BGR8 (make_config), the channel order the GOTURN Caffe model
+// and imshow expect, so no conversion is needed. Depth is not aligned: the
+// box is used on the depth frame as it is, since both images have the same
+// size. Boxes are in pixels of image().
+class goturn_step
+{
+public:
+    // Color is resized to the depth resolution right away, so neither stream
+    // needs more than the smallest mode covering 424x240
+    static stream_needs needs()
+    {
+        stream_needs n;
+        n.color_width = n.depth_width = 424;
+        n.color_height = n.depth_height = 240;
+        return n;
+    }
+
+    goturn_step() : _tracker(cv::TrackerGOTURN::create()) {}
+
+    // Prepares this frame's tracker input. Draw on a copy of image(), so
+    // overlays never reach the tracker.
+    const cv::Mat& prepare(const cv::Mat& color_bgr, const cv::Size& depth_size)
+    {
+        cv::resize(color_bgr, _image, depth_size);
+        return _image;
+    }
+
+    const cv::Mat& image() const { return _image; }
+
+    // (Re)starts tracking box on the prepared frame
+    bool init(const cv::Rect2d& box)
+    {
+        _initialized = _tracker->init(_image, box);
+        return _initialized;
+    }
+
+    // Tracks into the prepared frame. On success box is moved and distance is
+    // the robust depth inside it, meters (0 without valid depth).
+    bool update(const cv::Mat& depth_meters, cv::Rect2d& box, float& distance)
+    {
+        if (!_initialized || !_tracker->update(_image, box)) return false;
+        distance = robust_depth(depth_meters, box);
+        return true;
+    }
+
+private:
+    cv::Ptr<cv::Tracker> _tracker;
+    bool _initialized = false;
+    cv::Mat _image;
+};
+
+
+struct ssd_detection
+{
+    size_t object_class;
+    float confidence;
+    cv::Rect rect;          // in crop pixels
+    float distance;         // mean depth inside rect, meters
+};
+
+// MobileNet-SSD on the aligned color frame. The network only runs when
+// change_detector sees a change, or at least every max_staleness frames;
+// otherwise the previous detections are reused. Detections are mapped into
+// the center crop with the network's aspect ratio and get the mean aligned
+// depth inside them.
+class ssd_step
+{
+public:
+    static const int input_width = 300;
+    static const int input_height = 300;
+
+    // The network sees a 300x300 center crop of color; depth is only averaged
+    // inside detections after alignment, so its smallest mode is enough
+    static stream_needs needs()
+    {
+        stream_needs n;
+        n.color_width = input_width;
+        n.color_height = input_height;
+        n.depth_width = 424;
+        n.depth_height = 240;
+        return n;
+    }
+
+    explicit ssd_step(const dnn_config& cfg, int max_staleness = 15, float confidence_threshold = 0.8f)
+        : _net(load_dnn_model(cfg)), _scheduler(max_staleness), _threshold(confidence_threshold),
+        _align_to(RS2_STREAM_COLOR)
+    {
+    }
+
+    // data is the frameset as captured; it is aligned to color here.
+    const std::vector<ssd_detection>& process(const rs2::frameset& data)
+    {
+        auto aligned = _align_to.process(data);
+        cv::Mat color = frame_to_mat(aligned.get_color_frame());
+        cv::Mat depth = depth_frame_to_meters(aligned.get_depth_frame());
+
+        if (_scheduler.next(_changes, color) != detection_scheduler::SKIP)
+        {
+            // Layer names are not used: OpenVINO IR models may rename them
+            cv::Mat blob = cv::dnn::blobFromImage(color, 0.007843f, cv::Size(input_width, input_height), 127.5, false);
+            _net.setInput(blob);
+            cv::Mat detection = _net.forward();
+
+            // Cloned: on skipped frames the previous detections are used again
+            _detection_mat = cv::Mat(detection.size[2], detection.size[3], CV_32F, detection.ptr<float>()).clone();
+            _ran = true;
+        }
+        else
+        {
+            _ran = false;
+        }
+
+        const float ratio = input_width / (float)input_height;
+        cv::Size crop_size = color.cols / (float)color.rows > ratio
+            ? cv::Size(static_cast<int>(color.rows * ratio), color.rows)
+            : cv::Size(color.cols, static_cast<int>(color.cols / ratio));
+        _crop = cv::Rect(cv::Point((color.cols - crop_size.width) / 2, (color.rows - crop_size.height) / 2), crop_size);
+
+        _color = color(_crop);
+        cv::Mat depth_crop = depth(_crop);
+
+        _detections.clear();
+        for (int i = 0; i < _detection_mat.rows; i++)
+        {
+            float confidence = _detection_mat.at<float>(i, 2);
+            if (confidence <= _threshold) continue;
+
+            int x0 = static_cast<int>(_detection_mat.at<float>(i, 3) * _color.cols);
+            int y0 = static_cast<int>(_detection_mat.at<float>(i, 4) * _color.rows);
+            int x1 = static_cast<int>(_detection_mat.at<float>(i, 5) * _color.cols);
+            int y1 = static_cast<int>(_detection_mat.at<float>(i, 6) * _color.rows);
+
+            cv::Rect object = cv::Rect(x0, y0, x1 - x0, y1 - y0) & cv::Rect(0, 0, depth_crop.cols, depth_crop.rows);
+            if (object.area() == 0) continue;
+
+            ssd_detection d;
+            d.object_class = static_cast<size_t>(_detection_mat.at<float>(i, 1));
+            d.confidence = confidence;
+            d.rect = object;
+            d.distance = static_cast<float>(cv::mean(depth_crop(object))[0]);
+            _detections.push_back(d);
+        }
+        return _detections;
+    }
+
+    // Center crop of this frame's aligned color image, shares its data
+    const cv::Mat& color() const { return _color; }
+    // Crop rectangle in color pixels
+    const cv::Rect& crop() const { return _crop; }
+    // Whether the network ran on this frame
+    bool ran() const { return _ran; }
+
+private:
+    cv::dnn::Net _net;
+    change_detector _changes;
+    detection_scheduler _scheduler;
+    float _threshold;
+    rs2::align _align_to;
+
+    cv::Mat _detection_mat, _color;
+    cv::Rect _crop;
+    bool _ran = false;
+    std::vector<ssd_detection> _detections;
+};
+
+
+// Distance at the center of a fixed box in depth pixels, meters; 0 without
+// depth there or when the center is outside the frame.
+static float center_distance(const rs2::depth_frame& depth, const cv::Rect2d& box)
+{
+    float x = static_cast<float>(box.x + box.width / 2);
+    float y = static_cast<float>(box.y + box.height / 2);
+    if (x < 0 || y < 0 || x >= depth.get_width() || y >= depth.get_height()) return 0.f;
+    return depth.get_distance(static_cast<int>(x), static_cast<int>(y));
+}
@@ -0,0 +1,141 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+
+#pragma once
+
+#include <opencv2/opencv.hpp>   // Include OpenCV API
+
+// Cheap change detection used to gate the expensive detectors.
+//
+// The frame is shrunk with INTER_AREA, differenced against the reference
+// frame (the one the last detection ran on) and thresholded; the resulting
+// mask is shrunk again to the tile grid, which yields the fraction of changed
+// pixels per tile. Every step is a vectorized OpenCV primitive, so a 640x480
+// frame costs well under a millisecond.
+//
+// Accepts BGR or gray 8-bit frames and Z16 depth. For depth, pixels without a
+// depth value (0) in either frame are ignored, since holes flicker.
+class change_detector
+{
+public:
+    change_detector(cv::Size grid = cv::Size(8, 6), int scale = 4,
+        double pixel_threshold = 25, double tile_fraction = 0.02)
+        : _grid(grid), _scale(scale), _pixel_threshold(pixel_threshold), _tile_fraction(tile_fraction)
+    {
+    }
+
+    // Compares frame with the reference and returns the per-tile flags
+    // (CV_8U, grid sized, non-zero where the tile changed). Without a
+    // reference every tile is reported as changed.
+    const cv::Mat& update(const cv::Mat& frame)
+    {
+        cv::resize(frame, _small, cv::Size(), 1.0 / _scale, 1.0 / _scale, cv::INTER_AREA);
+        if (_small.channels() == 3) cv::cvtColor(_small, _small, cv::COLOR_BGR2GRAY);
+
+        if (_reference.empty() || _reference.size() != _small.size() || _reference.type() != _small.type())
+        {
+            _tiles = cv::Mat::ones(_grid, CV_8U);
+            _has_reference = false;
+            return _tiles;
+        }
+
+        cv::absdiff(_small, _reference, _diff);
+        if (_small.depth() == CV_16U)
+        {
+            cv::compare(_diff, _pixel_threshold, _mask, cv::CMP_GT);
+            cv::compare(_small, 0, _valid, cv::CMP_GT);
+            cv::bitwise_and(_mask, _valid, _mask);
+            cv::compare(_reference, 0, _valid, cv::CMP_GT);
+            cv::bitwise_and(_mask, _valid, _mask);
+        }
+        else
+        {
+            cv::threshold(_diff, _mask, _pixel_threshold, 255, cv::THRESH_BINARY);
+        }
+
+        // Area averaging the 0/255 mask gives the changed fraction per tile
+        cv::resize(_mask, _fraction, _grid, 0, 0, cv::INTER_AREA);
+        cv::compare(_fraction, _tile_fraction * 255, _tiles, cv::CMP_GT);
+        _has_reference = true;
+        return _tiles;
+    }
+
+    // Adopts the last frame passed to update() as the new reference.
+    void set_reference() { _small.copyTo(_reference); }
+
+    const cv::Mat& tiles() const { return _tiles; }
+    int changed_tiles() const { return cv::countNonZero(_tiles); }
+    bool has_reference() const { return _has_reference; }
+
+    // Bounding box of the changed tiles in frame coordinates, grown by margin
+    // pixels. Empty when nothing changed.
+    cv::Rect changed_region(cv::Size frame_size, int margin = 0) const
+    {
+        cv::Rect bounds;
+        for (int ty = 0; ty < _tiles.rows; ty++)
+            for (int tx = 0; tx < _tiles.cols; tx++)
+                if (_tiles.at<uchar>(ty, tx))
+                    bounds |= cv::Rect(tx, ty, 1, 1);
+
+        if (bounds.area() == 0) return cv::Rect();
+
+        const double sx = frame_size.width / (double)_grid.width;
+        const double sy = frame_size.height / (double)_grid.height;
+        cv::Rect region(cvFloor(bounds.x * sx) - margin, cvFloor(bounds.y * sy) - margin,
+            cvCeil(bounds.width * sx) + 2 * margin, cvCeil(bounds.height * sy) + 2 * margin);
+        return region & cv::Rect(cv::Point(), frame_size);
+    }
+
+private:
+    cv::Size _grid;
+    int _scale;
+    double _pixel_threshold;
+    double _tile_fraction;
+    bool _has_reference = false;
+
+    cv::Mat _small, _reference, _diff, _mask, _valid, _fraction, _tiles;
+};
+
+
+// Decides per frame whether to run the detector on the whole frame, only on
+// the changed region, or not at all. A full run is forced at least every
+// max_staleness frames, so results are never older than that even if the
+// change detector misses something.
+class detection_scheduler
+{
+public:
+    enum action { SKIP, ROI, FULL };
+
+    explicit detection_scheduler(int max_staleness = 30, double full_above = 0.5)
+        : _max_staleness(max_staleness), _full_above(full_above)
+    {
+    }
+
+    action next(change_detector& changes, const cv::Mat& frame)
+    {
+        const cv::Mat& tiles = changes.update(frame);
+        const int changed = changes.changed_tiles();
+
+        action a;
+        if (!changes.has_reference() || ++_since_full >= _max_staleness || changed > _full_above * tiles.total())
+            a = FULL;
+        else if (changed > 0)
+            a = ROI;
+        else
+            a = SKIP;
+
+        // Detection will run on this frame: changes are measured from here on
+        if (a != SKIP) changes.set_reference();
+        if (a == FULL) _since_full = 0;
+
+        _counts[a]++;
+        return a;
+    }
+
+    unsigned long long count(action a) const { return _counts[a]; }
+
+private:
+    int _max_staleness;
+    double _full_above;
+    int _since_full = 0;
+    unsigned long long _counts[3] = { 0, 0, 0 };
+};
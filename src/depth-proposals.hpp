@@ -0,0 +1,264 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+
+#pragma once
+
+#include <librealsense2/rs.hpp> // Include RealSense Cross Platform API
+#include <librealsense2/rsutil.h>
+#include <opencv2/opencv.hpp>   // Include OpenCV API
+#include <algorithm>
+#include <chrono>
+#include <cfloat>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Person candidates from depth alone, without running a CNN on the frame.
+//
+// 1. Deproject the Z16 frame with per-column / per-row lookup tables built
+//    from the stream intrinsics: X = z * lut_x[u], Y = z * lut_y[v]. The row
+//    loop is plain contiguous float math the compiler vectorizes.
+// 2. Voxel-downsample: each point sets one bit in a dense voxel bitset, and
+//    only the first point of a voxel is counted.
+// 3. Build a top-down grid (x across, z ahead) holding the voxel count and the
+//    highest point above the floor per cell.
+// 4. Label connected occupied cells and keep human-sized blobs.
+// 5. Move the corners of each blob's 3D box into the target stream with the
+//    depth-to-target extrinsics and project them with the target intrinsics;
+//    their bounding rectangle is the ROI.
+//
+// The camera is assumed to be roughly level, camera_height meters above the
+// floor, with +Y pointing down. Pass the color stream profile as target to get
+// ROIs in color pixels without aligning the frames; without a target the ROIs
+// are in depth pixels. last_ms() reports how long the latest process() call
+// took; tracker shows it in its window.
+
+struct person_proposal
+{
+    cv::Rect roi;           // in target stream pixels
+    float x;                // footprint center across, meters
+    float distance;         // nearest point of the blob ahead, meters
+    float height;           // top of the blob above the floor, meters
+    int voxels;
+};
+
+class depth_proposals
+{
+public:
+    struct settings
+    {
+        float camera_height = 1.0f;     // lens height above the floor, meters
+        float voxel = 0.05f;            // voxel edge, meters
+        int cells_per_voxel = 2;        // grid cell edge = voxel * cells_per_voxel
+        float half_width = 4.0f;        // grid covers x in [-half_width, half_width]
+        float max_range = 6.0f;         // and z in [min_range, max_range]
+        float min_range = 0.3f;
+        float floor_margin = 0.15f;     // points this close to the floor are ignored
+        float min_height = 1.0f;        // person top above the floor
+        float max_height = 2.2f;
+        float min_footprint = 0.2f;     // larger footprint side, meters
+        float max_footprint = 1.2f;
+        int min_voxels = 40;
+        int row_stride = 2;             // deproject every n-th row
+    };
+
+    explicit depth_proposals(const settings& s = settings()) : _s(s) {}
+
+    // ROIs in depth pixels
+    const std::vector<person_proposal>& process(const rs2::depth_frame& depth)
+    {
+        return process(depth, depth.get_profile().as<rs2::video_stream_profile>());
+    }
+
+    // ROIs in the pixels of target, typically the color stream profile
+    const std::vector<person_proposal>& process(const rs2::depth_frame& depth, const rs2::video_stream_profile& target)
+    {
+        auto start = std::chrono::steady_clock::now();
+
+        auto depth_profile = depth.get_profile().as<rs2::video_stream_profile>();
+        auto intrin = depth_profile.get_intrinsics();
+        if (intrin.width != _intrin.width || intrin.height != _intrin.height ||
+            intrin.fx != _intrin.fx || intrin.fy != _intrin.fy)
+            build_tables(intrin);
+
+        _target_intrin = target.get_intrinsics();
+        _to_target = depth_profile.get_extrinsics_to(target);
+
+        accumulate(static_cast<const uint16_t*>(depth.get_data()), depth.get_units(),
+            depth.get_stride_in_bytes() / (int)sizeof(uint16_t));
+        cluster();
+
+        _last_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        return _proposals;
+    }
+
+    const std::vector<person_proposal>& proposals() const { return _proposals; }
+    double last_ms() const { return _last_ms; }
+    // Top-down views, rows = z (near to far), cols = x (left to right)
+    const cv::Mat& height_map() const { return _height; }
+    const cv::Mat& count_map() const { return _count; }
+
+private:
+    void build_tables(const rs2_intrinsics& intrin)
+    {
+        _intrin = intrin;
+
+        // D400 depth streams have no distortion, so the pinhole model is exact
+        _lut_x.resize(intrin.width);
+        _lut_y.resize(intrin.height);
+        for (int u = 0; u < intrin.width; u++) _lut_x[u] = (u - intrin.ppx) / intrin.fx;
+        for (int v = 0; v < intrin.height; v++) _lut_y[v] = (v - intrin.ppy) / intrin.fy;
+
+        _row_x.resize(intrin.width);
+        _row_y.resize(intrin.width);
+        _row_z.resize(intrin.width);
+
+        _vx = static_cast<int>(2 * _s.half_width / _s.voxel);
+        _vy = static_cast<int>((_s.max_height + 0.3f) / _s.voxel);
+        _vz = static_cast<int>(_s.max_range / _s.voxel);
+        _voxels.assign(((size_t)_vx * _vy * _vz + 63) / 64, 0);
+
+        _count.create(_vz / _s.cells_per_voxel, _vx / _s.cells_per_voxel, CV_32S);
+        _height.create(_count.size(), CV_32F);
+    }
+
+    void accumulate(const uint16_t* data, float units, int stride)
+    {
+        std::fill(_voxels.begin(), _voxels.end(), 0);
+        _count.setTo(0);
+        _height.setTo(0);
+
+        const int width = _intrin.width;
+        const float inv_voxel = 1.f / _s.voxel;
+        const float top = _s.max_height + 0.3f;
+
+        for (int v = 0; v < _intrin.height; v += _s.row_stride)
+        {
+            const uint16_t* row = data + (size_t)v * stride;
+            const float ly = _lut_y[v];
+            float* xs = _row_x.data();
+            float* ys = _row_y.data();
+            float* zs = _row_z.data();
+
+            // Vectorizable: no branches, contiguous loads and stores
+            for (int u = 0; u < width; u++)
+            {
+                float z = row[u] * units;
+                zs[u] = z;
+                xs[u] = z * _lut_x[u];
+                ys[u] = z * ly;
+            }
+
+            for (int u = 0; u < width; u++)
+            {
+                float z = zs[u];
+                if (z < _s.min_range || z >= _s.max_range) continue;
+
+                float h = _s.camera_height - ys[u];   // height above the floor
+                if (h < _s.floor_margin || h >= top) continue;
+
+                int ix = static_cast<int>((xs[u] + _s.half_width) * inv_voxel);
+                if (ix < 0 || ix >= _vx) continue;
+                int iy = static_cast<int>(h * inv_voxel);
+                int iz = static_cast<int>(z * inv_voxel);
+                if (iy >= _vy || iz >= _vz) continue;
+
+                size_t bit = ((size_t)iz * _vy + iy) * _vx + ix;
+                uint64_t mask = 1ull << (bit & 63);
+                if (_voxels[bit >> 6] & mask) continue;
+                _voxels[bit >> 6] |= mask;
+
+                int cx = ix / _s.cells_per_voxel;
+                int cz = iz / _s.cells_per_voxel;
+                if (cx >= _count.cols || cz >= _count.rows) continue;
+
+                _count.at<int>(cz, cx)++;
+                float& cell_top = _height.at<float>(cz, cx);
+                if (h > cell_top) cell_top = h;
+            }
+        }
+    }
+
+    void cluster()
+    {
+        _proposals.clear();
+
+        cv::compare(_count, 2, _occupied, cv::CMP_GE);
+        int n = cv::connectedComponentsWithStats(_occupied, _labels, _stats, _centroids, 8, CV_32S);
+
+        const float cell = _s.voxel * _s.cells_per_voxel;
+
+        for (int i = 1; i < n; i++)
+        {
+            int cx = _stats.at<int>(i, cv::CC_STAT_LEFT);
+            int cz = _stats.at<int>(i, cv::CC_STAT_TOP);
+            int cw = _stats.at<int>(i, cv::CC_STAT_WIDTH);
+            int ch = _stats.at<int>(i, cv::CC_STAT_HEIGHT);
+
+            float footprint = std::max(cw, ch) * cell;
+            if (footprint < _s.min_footprint || footprint > _s.max_footprint) continue;
+
+            int voxels = 0;
+            float height = 0;
+            for (int z = cz; z < cz + ch; z++)
+            {
+                for (int x = cx; x < cx + cw; x++)
+                {
+                    if (_labels.at<int>(z, x) != i) continue;
+                    voxels += _count.at<int>(z, x);
+                    height = std::max(height, _height.at<float>(z, x));
+                }
+            }
+            if (voxels < _s.min_voxels || height < _s.min_height || height > _s.max_height) continue;
+
+            person_proposal p;
+            p.x = (cx + cw * 0.5f) * cell - _s.half_width;
+            p.distance = std::max(_s.min_range, cz * cell);
+            p.height = height;
+            p.voxels = voxels;
+
+            // The blob's 3D box, from its top down to the floor, in depth camera
+            // coordinates
+            const float xs[2] = { cx * cell - _s.half_width, (cx + cw) * cell - _s.half_width };
+            const float ys[2] = { _s.camera_height - height, _s.camera_height };
+            const float zs[2] = { p.distance, std::max(p.distance, (cz + ch) * cell) };
+
+            float left = FLT_MAX, top = FLT_MAX, right = -FLT_MAX, bottom = -FLT_MAX;
+            for (float x : xs) for (float y : ys) for (float z : zs)
+            {
+                float corner[3] = { x, y, z }, in_target[3], pixel[2];
+                rs2_transform_point_to_point(in_target, &_to_target, corner);
+                if (in_target[2] <= 0) continue;
+                rs2_project_point_to_pixel(pixel, &_target_intrin, in_target);
+                left = std::min(left, pixel[0]);
+                top = std::min(top, pixel[1]);
+                right = std::max(right, pixel[0]);
+                bottom = std::max(bottom, pixel[1]);
+            }
+            if (left > right) continue;
+
+            cv::Point tl(cvFloor(left), cvFloor(top));
+            cv::Point br(cvCeil(right), cvCeil(bottom));
+            p.roi = cv::Rect(tl, br) & cv::Rect(0, 0, _target_intrin.width, _target_intrin.height);
+
+            if (p.roi.area() > 0) _proposals.push_back(p);
+        }
+
+        std::sort(_proposals.begin(), _proposals.end(),
+            [](const person_proposal& a, const person_proposal& b) { return a.distance < b.distance; });
+    }
+
+    settings _s;
+    rs2_intrinsics _intrin = {};
+    rs2_intrinsics _target_intrin = {};
+    rs2_extrinsics _to_target = {};
+    double _last_ms = 0;
+
+    std::vector<float> _lut_x, _lut_y;
+    std::vector<float> _row_x, _row_y, _row_z;
+
+    int _vx = 0, _vy = 0, _vz = 0;
+    std::vector<uint64_t> _voxels;
+
+    cv::Mat _count, _height, _occupied, _labels, _stats, _centroids;
+    std::vector<person_proposal> _proposals;
+};
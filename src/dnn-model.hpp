@@ -0,0 +1,148 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+
+#pragma once
+
+#include <opencv2/opencv.hpp>   // Include OpenCV API
+#include <opencv2/dnn.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// MobileNet-SSD loader with a selectable OpenCV DNN backend, precision and
+// thread count. Model files are looked up in model_dir:
+//
+//   fp32  MobileNetSSD_deploy.prototxt / MobileNetSSD_deploy.caffemodel
+//   fp16  MobileNetSSD_deploy_fp16.xml / .bin  (OpenVINO IR)
+//   int8  MobileNetSSD_deploy_int8.xml / .bin  (OpenVINO IR, post-training quantized)
+//
+// With the default OpenCV backend fp16 runs the fp32 weights on the
+// DNN_TARGET_CPU_FP16 target (OpenCV 4.10 and later); int8 needs OpenVINO.
+
+static const char* classNames[] = { "background",
+    "aeroplane", "bicycle", "bird", "boat",
+    "bottle", "bus", "car", "cat", "chair",
+    "cow", "diningtable", "dog", "horse",
+    "motorbike", "person", "pottedplant",
+    "sheep", "sofa", "train", "tvmonitor" };
+
+struct dnn_config
+{
+    std::string backend = "opencv";    // "opencv" or "openvino"
+    std::string precision = "fp32";    // "fp32", "fp16" or "int8"
+    int threads = 0;                   // intra-op threads, 0 uses the default; opencv backend only
+    std::string model_dir = ".";
+
+    std::string name() const
+    {
+        return backend + "/" + precision + "/" + (threads > 0 ? std::to_string(threads) : std::string("auto")) + "t";
+    }
+};
+
+static bool file_exists(const std::string& path)
+{
+    return std::ifstream(path).good();
+}
+
+static bool openvino_available()
+{
+    auto targets = cv::dnn::getAvailableTargets(cv::dnn::DNN_BACKEND_INFERENCE_ENGINE);
+    return std::find(targets.begin(), targets.end(), cv::dnn::DNN_TARGET_CPU) != targets.end();
+}
+
+// OpenCV runs DNN_TARGET_CPU_FP16 as fp32 on CPUs without fp16 arithmetic,
+// so ask for the targets this CPU really offers.
+static bool cpu_fp16_available()
+{
+#if CV_VERSION_MAJOR > 4 || (CV_VERSION_MAJOR == 4 && CV_VERSION_MINOR >= 10)
+    auto targets = cv::dnn::getAvailableTargets(cv::dnn::DNN_BACKEND_OPENCV);
+    return std::find(targets.begin(), targets.end(), cv::dnn::DNN_TARGET_CPU_FP16) != targets.end();
+#else
+    return false;
+#endif
+}
+
+// Model and weights paths for a configuration.
+static std::pair<std::string, std::string> dnn_model_files(const dnn_config& cfg)
+{
+    const std::string base = cfg.model_dir + "/MobileNetSSD_deploy";
+
+    if (cfg.precision == "fp32" || cfg.backend == "opencv")
+        return { base + ".prototxt", base + ".caffemodel" };
+
+    return { base + "_" + cfg.precision + ".xml", base + "_" + cfg.precision + ".bin" };
+}
+
+// Whether cfg can run on this machine with the model files present.
+static bool dnn_config_supported(const dnn_config& cfg)
+{
+    if (cfg.backend == "openvino" && !openvino_available()) return false;
+    if (cfg.backend == "opencv" && cfg.precision == "fp16" && !cpu_fp16_available()) return false;
+    if (cfg.backend == "opencv" && cfg.precision == "int8") return false;
+
+    auto files = dnn_model_files(cfg);
+    return file_exists(files.first) && file_exists(files.second);
+}
+
+static cv::dnn::Net load_dnn_model(const dnn_config& cfg)
+{
+    using namespace cv::dnn;
+
+    if (cfg.backend != "opencv" && cfg.backend != "openvino")
+        throw std::runtime_error("unknown DNN backend " + cfg.backend);
+    if (cfg.precision != "fp32" && cfg.precision != "fp16" && cfg.precision != "int8")
+        throw std::runtime_error("unknown model precision " + cfg.precision);
+    // cv::setNumThreads does not reach OpenVINO's CPU plugin, and OpenCV has
+    // no way to pass it a thread count
+    if (cfg.backend == "openvino" && cfg.threads > 0)
+        throw std::runtime_error("the thread count cannot be set for the openvino backend");
+    if (!dnn_config_supported(cfg))
+        throw std::runtime_error("DNN configuration " + cfg.name() + " is not available on this machine");
+
+    auto files = dnn_model_files(cfg);
+    // .prototxt/.caffemodel is read as Caffe, .xml/.bin as OpenVINO IR
+    Net net = files.first.size() > 4 && files.first.compare(files.first.size() - 4, 4, ".xml") == 0
+        ? readNet(files.first, files.second)
+        : readNetFromCaffe(files.first, files.second);
+
+    if (cfg.backend == "openvino")
+    {
+        net.setPreferableBackend(DNN_BACKEND_INFERENCE_ENGINE);
+        net.setPreferableTarget(DNN_TARGET_CPU);
+    }
+    else
+    {
+        net.setPreferableBackend(DNN_BACKEND_OPENCV);
+#if CV_VERSION_MAJOR > 4 || (CV_VERSION_MAJOR == 4 && CV_VERSION_MINOR >= 10)
+        net.setPreferableTarget(cfg.precision == "fp16" ? DNN_TARGET_CPU_FP16 : DNN_TARGET_CPU);
+#else
+        net.setPreferableTarget(DNN_TARGET_CPU);
+#endif
+    }
+
+    // Process-wide setting: the most recently loaded configuration wins for
+    // every Net. A negative count restores OpenCV's default.
+    cv::setNumThreads(cfg.threads > 0 ? cfg.threads : -1);
+
+    return net;
+}
+
+// Consumes --backend, --precision, --threads and --models from argv. Other
+// arguments are returned untouched, in order. --threads only applies to the
+// opencv backend; load_dnn_model rejects it with openvino.
+static std::vector<std::string> parse_dnn_args(int argc, char* argv[], dnn_config& cfg)
+{
+    std::vector<std::string> rest;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--backend" && i + 1 < argc) cfg.backend = argv[++i];
+        else if (arg == "--precision" && i + 1 < argc) cfg.precision = argv[++i];
+        else if (arg == "--threads" && i + 1 < argc) cfg.threads = atoi(argv[++i]);
+        else if (arg == "--models" && i + 1 < argc) cfg.model_dir = argv[++i];
+        else rest.push_back(arg);
+    }
+    return rest;
+}
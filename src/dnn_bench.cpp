@@ -0,0 +1,249 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+
+#include <librealsense2/rs.hpp> // Include RealSense Cross Platform API
+#include <opencv2/opencv.hpp>   // Include OpenCV API
+#include <opencv2/dnn.hpp>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <algorithm>
+#include <sstream>
+#include "cv-helpers.hpp"
+#include "dnn-model.hpp"
+
+using namespace std;
+using namespace cv;
+using namespace cv::dnn;
+
+// Usage: dnn_bench <file.bag> [--frames N] [--threads 1,2,4] [--models DIR]
+//
+// Replays the recorded color stream once, then runs the same frames through
+// every DNN configuration available on this machine: each backend and
+// precision, the opencv backend at each listed intra-op thread count
+// (0 = OpenCV default). OpenVINO manages its own CPU threads, so it gets one
+// row per precision. Backend and precision are always swept, so --backend
+// and --precision are rejected. For each one it reports the per-frame forward latency
+// distribution and how well its detections agree with the opencv/fp32
+// baseline (recall and precision of same-class boxes at IoU >= 0.5), so the
+// fastest configuration that keeps accuracy can be picked.
+
+const size_t inWidth = 300;
+const size_t inHeight = 300;
+const float WHRatio = inWidth / (float)inHeight;
+const float inScaleFactor = 0.007843f;
+const float meanVal = 127.5;
+const float confidenceThreshold = 0.8f;
+const int warmupFrames = 5;
+
+struct detection
+{
+    size_t objectClass;
+    Rect2f object;      // normalized coordinates
+};
+
+static vector<detection> run_ssd(Net& net, const Mat& color_mat)
+{
+    Mat inputBlob = blobFromImage(color_mat, inScaleFactor, Size(inWidth, inHeight), meanVal, false);
+    net.setInput(inputBlob);
+    Mat out = net.forward();
+    Mat detectionMat(out.size[2], out.size[3], CV_32F, out.ptr<float>());
+
+    vector<detection> detections;
+    for (int i = 0; i < detectionMat.rows; i++)
+    {
+        if (detectionMat.at<float>(i, 2) <= confidenceThreshold) continue;
+
+        float x0 = detectionMat.at<float>(i, 3), y0 = detectionMat.at<float>(i, 4);
+        float x1 = detectionMat.at<float>(i, 5), y1 = detectionMat.at<float>(i, 6);
+        detections.push_back({ (size_t)detectionMat.at<float>(i, 1), Rect2f(x0, y0, x1 - x0, y1 - y0) });
+    }
+    return detections;
+}
+
+static float iou(const Rect2f& a, const Rect2f& b)
+{
+    float inter = (a & b).area();
+    float uni = a.area() + b.area() - inter;
+    return uni > 0 ? inter / uni : 0.f;
+}
+
+// Greedy one-to-one matching of same-class boxes with IoU >= 0.5.
+static void match(const vector<detection>& baseline, const vector<detection>& candidate,
+    int& matched, double& iou_sum)
+{
+    vector<bool> used(candidate.size(), false);
+    for (auto& b : baseline)
+    {
+        int best = -1;
+        float best_iou = 0.5f;
+        for (size_t j = 0; j < candidate.size(); j++)
+        {
+            if (used[j] || candidate[j].objectClass != b.objectClass) continue;
+            float v = iou(b.object, candidate[j].object);
+            if (v >= best_iou) { best = (int)j; best_iou = v; }
+        }
+        if (best >= 0)
+        {
+            used[best] = true;
+            matched++;
+            iou_sum += best_iou;
+        }
+    }
+}
+
+static double percentile(vector<double> values, double p)
+{
+    if (values.empty()) return 0;
+    size_t k = min(values.size() - 1, (size_t)(p / 100.0 * values.size()));
+    nth_element(values.begin(), values.begin() + k, values.end());
+    return values[k];
+}
+
+
+int main(int argc, char* argv[]) try
+{
+    const char* usage = "Usage: dnn_bench <file.bag> [--frames N] [--threads 1,2,4] [--models DIR]";
+
+    dnn_config base;
+    string bag;
+    size_t max_frames = 300;
+    vector<int> thread_counts;
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        if (arg == "--frames" && i + 1 < argc) max_frames = atoi(argv[++i]);
+        else if (arg == "--models" && i + 1 < argc) base.model_dir = argv[++i];
+        else if (arg == "--threads" && i + 1 < argc)
+        {
+            stringstream list(argv[++i]);
+            string item;
+            while (getline(list, item, ',')) thread_counts.push_back(atoi(item.c_str()));
+        }
+        else if (arg == "--backend" || arg == "--precision")
+        {
+            cerr << arg << " is not accepted: every backend and precision is benchmarked" << endl;
+            return EXIT_FAILURE;
+        }
+        else if (arg.compare(0, 2, "--") == 0 || !bag.empty())
+        {
+            cerr << usage << endl;
+            return EXIT_FAILURE;
+        }
+        else bag = arg;
+    }
+    if (bag.empty())
+    {
+        cerr << usage << endl;
+        return EXIT_FAILURE;
+    }
+    if (thread_counts.empty()) thread_counts.push_back(0);
+
+    // Decode the sequence once so every configuration sees identical input
+    rs2::pipeline pipe;
+    rs2::config cfg;
+    cfg.enable_device_from_file(bag, false);
+    auto config = pipe.start(cfg);
+    config.get_device().as<rs2::playback>().set_real_time(false);
+
+    auto profile = config.get_stream(RS2_STREAM_COLOR).as<rs2::video_stream_profile>();
+    Size cropSize;
+    if (profile.width() / (float)profile.height() > WHRatio)
+        cropSize = Size(static_cast<int>(profile.height() * WHRatio), profile.height());
+    else
+        cropSize = Size(profile.width(), static_cast<int>(profile.width() / WHRatio));
+    Rect crop(Point((profile.width() - cropSize.width) / 2, (profile.height() - cropSize.height) / 2), cropSize);
+
+    vector<Mat> frames;
+    rs2::frameset data;
+    while (frames.size() < max_frames && pipe.try_wait_for_frames(&data, 1000))
+    {
+        auto color_frame = data.get_color_frame();
+        if (color_frame) frames.push_back(frame_to_mat(color_frame)(crop).clone());
+    }
+    pipe.stop();
+
+    if (frames.size() <= (size_t)warmupFrames)
+    {
+        cerr << bag << ": not enough color frames to benchmark" << endl;
+        return EXIT_FAILURE;
+    }
+
+    // Baseline (opencv/fp32 at the first thread count) first, then every other
+    // backend/precision/thread count this machine supports
+    vector<dnn_config> configs;
+    for (string backend : { "opencv", "openvino" })
+    {
+        for (string precision : { "fp32", "fp16", "int8" })
+        {
+            for (int threads : backend == "opencv" ? thread_counts : vector<int>{ 0 })
+            {
+                dnn_config c = base;
+                c.backend = backend;
+                c.precision = precision;
+                c.threads = threads;
+                if (dnn_config_supported(c)) configs.push_back(c);
+                else cout << "skipping " << c.name() << " (backend, target or model files not available)" << endl;
+            }
+        }
+    }
+    if (configs.empty() || configs[0].backend != "opencv" || configs[0].precision != "fp32")
+    {
+        cerr << "The opencv/fp32 baseline model is required" << endl;
+        return EXIT_FAILURE;
+    }
+
+    vector<vector<detection>> baseline;
+
+    printf("%-24s %8s %8s %8s %8s %8s %9s %9s %9s\n",
+        "config", "mean ms", "p50 ms", "p90 ms", "p99 ms", "max ms", "recall", "precision", "mean IoU");
+
+    for (auto& c : configs)
+    {
+        Net net = load_dnn_model(c);
+
+        for (int i = 0; i < warmupFrames; i++) run_ssd(net, frames[i]);
+
+        vector<double> latency;
+        vector<vector<detection>> results;
+        for (auto& frame : frames)
+        {
+            auto start = chrono::steady_clock::now();
+            results.push_back(run_ssd(net, frame));
+            latency.push_back(chrono::duration<double, milli>(chrono::steady_clock::now() - start).count());
+        }
+
+        if (baseline.empty()) baseline = results;
+
+        int reference = 0, produced = 0, matched = 0;
+        double iou_sum = 0;
+        for (size_t i = 0; i < frames.size(); i++)
+        {
+            reference += (int)baseline[i].size();
+            produced += (int)results[i].size();
+            match(baseline[i], results[i], matched, iou_sum);
+        }
+
+        double mean_ms = 0;
+        for (double v : latency) mean_ms += v;
+        mean_ms /= latency.size();
+
+        printf("%-24s %8.2f %8.2f %8.2f %8.2f %8.2f %8.1f%% %8.1f%% %9.3f\n", c.name().c_str(), mean_ms,
+            percentile(latency, 50), percentile(latency, 90), percentile(latency, 99),
+            *max_element(latency.begin(), latency.end()),
+            reference ? 100.0 * matched / reference : 100.0,
+            produced ? 100.0 * matched / produced : 100.0,
+            matched ? iou_sum / matched : 1.0);
+    }
+
+    return EXIT_SUCCESS;
+}
+catch (const rs2::error& e)
+{
+    std::cerr << "RealSense error calling " << e.get_failed_function() << "(" << e.get_failed_args() << "):\n    " << e.what() << std::endl;
+    return EXIT_FAILURE;
+}
+catch (const std::exception& e)
+{
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+}
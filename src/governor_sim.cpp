@@ -0,0 +1,112 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "stream-governor.hpp"
+
+// Drives frame_time_governor with simulated_source, no camera needed.
+// The ladder is built by build_stream_ladder from D435 color (BGR8) and
+// depth (Z16) modes for main.cpp's needs, the same way stream_ladder builds
+// it from a connected camera. The middle third of the run carries a load
+// spike (other processes competing for the cores): the governor has to step
+// down to hold the target, then back to the unloaded level once the load
+// goes away. Exits with failure if it does not settle, or if a level change
+// restarts the streams without changing the captured resolution.
+
+static void add_modes(std::vector<video_mode>& modes, int width, int height, std::vector<int> rates)
+{
+    for (int fps : rates) modes.push_back({ width, height, fps });
+}
+
+int main()
+{
+    std::vector<video_mode> color_modes, depth_modes;
+    for (auto& r : std::vector<std::pair<int, int>>{ { 320, 180 }, { 320, 240 }, { 424, 240 }, { 640, 360 },
+        { 640, 480 }, { 848, 480 }, { 960, 540 } })
+        add_modes(color_modes, r.first, r.second, { 6, 15, 30, 60 });
+    add_modes(color_modes, 1280, 720, { 6, 15, 30 });
+    add_modes(color_modes, 1920, 1080, { 6, 15, 30 });
+
+    add_modes(depth_modes, 256, 144, { 90 });
+    for (auto& r : std::vector<std::pair<int, int>>{ { 424, 240 }, { 480, 270 }, { 640, 360 }, { 640, 480 }, { 848, 480 } })
+        add_modes(depth_modes, r.first, r.second, { 6, 15, 30, 60, 90 });
+    add_modes(depth_modes, 1280, 720, { 6, 15, 30 });
+
+    // main.cpp: a 200x200 color image for the cascade, no depth
+    stream_needs needs;
+    needs.color_width = 200;
+    needs.color_height = 200;
+    auto ladder = build_stream_ladder(color_modes, depth_modes, needs);
+
+    bool ladder_ok = true;
+    for (size_t i = 0; i < ladder.size(); i++)
+    {
+        auto& l = ladder[i];
+        printf("level %zu: color %dx%d depth %dx%d @ %d fps, scale %.3f\n",
+            i, l.color_width, l.color_height, l.depth_width, l.depth_height, l.fps, l.scale);
+        // Every step must change the cost the governor predicts from
+        if (i > 0 && !(l.cost() > ladder[i - 1].cost())) ladder_ok = false;
+        if (l.fps != ladder.back().fps) ladder_ok = false;
+    }
+
+    frame_time_governor::settings settings;
+    settings.target_ms = 33.0;
+    settings.fixed_ms = 5.0;
+    frame_time_governor governor(ladder, settings, ladder.size() - 1);
+
+    // 5 ms fixed + 475 ms per processed megapixel: the negotiated profile
+    // (about 24 ms) fits the target unloaded, not under the spike
+    simulated_source source(settings.fixed_ms, 475.0);
+    source.apply(governor.current());
+    unsigned resolution_changes = 0;
+
+    const int frames = 3000;
+    double settled_normal = 0, settled_loaded = 0;
+    size_t normal_level = 0, loaded_level = 0;
+
+    for (int i = 0; i < frames; i++)
+    {
+        source.set_load(i >= frames / 3 && i < 2 * frames / 3 ? 2.5 : 1.0);
+
+        stream_level previous = governor.current();
+        if (governor.observe(source.next_frame_ms()))
+        {
+            auto& l = governor.current();
+            printf("frame %4d: level %zu, color %dx%d depth %dx%d @ %d fps, scale %.3f\n",
+                i, governor.level(), l.color_width, l.color_height, l.depth_width, l.depth_height, l.fps, l.scale);
+            if (l.color_width != previous.color_width || l.color_height != previous.color_height ||
+                l.depth_width != previous.depth_width || l.depth_height != previous.depth_height)
+                resolution_changes++;
+            source.apply(l);
+        }
+
+        if (i == frames / 3 - 1)
+        {
+            settled_normal = governor.smoothed_ms();
+            normal_level = governor.level();
+        }
+        if (i == 2 * frames / 3 - 1)
+        {
+            settled_loaded = governor.smoothed_ms();
+            loaded_level = governor.level();
+        }
+    }
+
+    printf("smoothed frame time: %.1f ms unloaded, %.1f ms under load, %.1f ms after; "
+        "%u level changes, %u stream restarts, %u resolution changes\n",
+        settled_normal, settled_loaded, governor.smoothed_ms(), governor.changes(), source.restarts(), resolution_changes);
+
+    const double limit = settings.target_ms * settings.down_above;
+    // The first restart is the initial start
+    bool no_extra_restarts = source.restarts() == resolution_changes + 1;
+    bool settled = settled_normal <= limit && settled_loaded <= limit && governor.smoothed_ms() <= limit
+        && loaded_level < normal_level && governor.level() == normal_level;
+
+    if (!ladder_ok) printf("ladder has a level that is not cheaper than the next one, or mixes frame rates\n");
+    if (!no_extra_restarts) printf("streams restarted without a resolution change\n");
+    if (governor.level() != normal_level) printf("did not return to the unloaded level %zu\n", normal_level);
+    bool ok = ladder_ok && no_extra_restarts && settled;
+    printf("%s\n", ok ? "PASS" : "FAIL");
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,151 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+
+#pragma once
+
+#include <librealsense2/rs.hpp> // Include RealSense Cross Platform API
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <mutex>
+
+// Latency-first capture: hand to pipeline::start as the frame callback
+// instead of calling wait_for_frames().
+//
+// Every stream has a single "latest wins" slot. A frame that arrives before
+// the previous one of the same stream was consumed replaces it and is counted
+// as dropped, so processing always starts from the newest data and never
+// works through a backlog. wait() pairs the newest color frame with a depth
+// frame whose hardware timestamp is within tolerance_ms, rather than trusting
+// frameset order, and returns them as one frameset (so rs2::align still
+// works).
+class latest_frame_pair
+{
+public:
+    typedef std::chrono::steady_clock clock;
+
+    enum { COLOR, DEPTH, STREAMS };
+
+    explicit latest_frame_pair(double tolerance_ms = 10.0)
+        : _tolerance_ms(tolerance_ms),
+        // Bundles the chosen color and depth frames into one composite frame
+        _combine([this](rs2::frame color, rs2::frame_source& src)
+        {
+            src.frame_ready(src.allocate_composite_frame({ color, _pair_depth }));
+        })
+    {
+        _combine.start(_combined);
+    }
+
+    // Frame callback, runs on the librealsense thread.
+    void operator()(rs2::frame f)
+    {
+        if (auto fs = f.as<rs2::frameset>())
+        {
+            for (auto&& sub : fs) store(sub);
+        }
+        else
+        {
+            store(f);
+        }
+    }
+
+    // Waits for a fresh color frame paired with a depth frame within the
+    // tolerance. Returns false on timeout.
+    bool wait(rs2::frameset& out, unsigned timeout_ms = 1000)
+    {
+        auto deadline = clock::now() + std::chrono::milliseconds(timeout_ms);
+        std::unique_lock<std::mutex> lock(_mutex);
+
+        while (true)
+        {
+            slot& color = _slots[COLOR];
+            slot& depth = _slots[DEPTH];
+
+            if (color.fresh && depth.frame)
+            {
+                double dt = depth.frame.get_timestamp() - color.frame.get_timestamp();
+                if (std::abs(dt) <= _tolerance_ms)
+                {
+                    rs2::frame c = color.frame;
+                    _pair_depth = depth.frame;
+                    _arrival = std::min(color.arrival, depth.arrival);
+                    color.fresh = false;
+                    depth.fresh = false;
+                    lock.unlock();
+
+                    _combine.invoke(c);
+                    out = _combined.wait_for_frame();
+                    return true;
+                }
+
+                // Depth is newer by more than the tolerance: this color frame
+                // will never get a partner, wait for the next one.
+                if (dt > 0)
+                {
+                    color.fresh = false;
+                    _unpaired++;
+                }
+                // Otherwise depth lags behind; wait for a newer depth frame.
+            }
+
+            if (_cv.wait_until(lock, deadline) == std::cv_status::timeout) return false;
+        }
+    }
+
+    // Age of the last returned pair: time since its older frame reached the host.
+    double age_ms() const
+    {
+        return std::chrono::duration<double, std::milli>(clock::now() - _arrival).count();
+    }
+
+    unsigned long long received(int stream) const { return _received[stream]; }
+    unsigned long long dropped(int stream) const { return _dropped[stream]; }
+    unsigned long long unpaired() const { return _unpaired; }
+
+private:
+    struct slot
+    {
+        rs2::frame frame;
+        clock::time_point arrival;
+        bool fresh = false;
+    };
+
+    void store(const rs2::frame& f)
+    {
+        int stream;
+        switch (f.get_profile().stream_type())
+        {
+        case RS2_STREAM_COLOR: stream = COLOR; break;
+        case RS2_STREAM_DEPTH: stream = DEPTH; break;
+        default: return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            slot& s = _slots[stream];
+            if (s.fresh) _dropped[stream]++;
+            s.frame = f;
+            s.arrival = clock::now();
+            s.fresh = true;
+            _received[stream]++;
+        }
+        _cv.notify_one();
+    }
+
+    double _tolerance_ms;
+
+    std::mutex _mutex;
+    std::condition_variable _cv;
+    slot _slots[STREAMS];
+    clock::time_point _arrival;
+
+    std::atomic<unsigned long long> _received[STREAMS] = { {0}, {0} };
+    std::atomic<unsigned long long> _dropped[STREAMS] = { {0}, {0} };
+    std::atomic<unsigned long long> _unpaired{ 0 };
+
+    rs2::frame _pair_depth;
+    rs2::processing_block _combine;
+    rs2::frame_queue _combined;
+};
@@ -4,16 +4,34 @@
 #include <librealsense2/rs.hpp> // Include RealSense Cross Platform API
 #include <opencv2/opencv.hpp>   // Include OpenCV API
 #include <vector>
+#include <algorithm>
+#include <chrono>
+#include "change-detector.hpp"
+#include "stream-profile.hpp"
 
 int main(int argc, char* argv[]) try
 {
     // Declare depth colorizer for pretty visualization of depth data
     rs2::colorizer color_map;
 
+    // The cascade only sees a 200x200 color image and no depth: capture the
+    // smallest color mode covering that, and let the governor lower the
+    // processing scale, with the capture resolution following it, to hold
+    // 33 ms per frame. The frame rate stays at 30 fps.
+    stream_needs needs;
+    needs.color_width = 200;
+    needs.color_height = 200;
+    auto device = first_device();
+    auto ladder = stream_ladder(device, needs);
+
+    frame_time_governor::settings governor_settings;
+    governor_settings.target_ms = 33.0;
+    frame_time_governor governor(ladder, governor_settings, ladder.size() - 1);
+
     // Declare RealSense pipeline, encapsulating the actual device and sensors
     rs2::pipeline pipe;
-    // Start streaming with default recommended configuration
-    pipe.start();
+    // Start streaming with the negotiated configuration
+    pipe.start(make_config(device, governor.current()));
 
     using namespace cv;
     const auto window_name = "Display Image";
@@ -23,9 +41,15 @@ int main(int argc, char* argv[]) try
 
     namedWindow(window_name, WINDOW_AUTOSIZE);
 
+    // Skip the cascade on static frames; rerun it at least every 30 frames
+    change_detector changes(Size(8, 8), 2);
+    detection_scheduler scheduler(30);
+    std::vector<Rect> faces;
+
     while (waitKey(1) < 0 && getWindowProperty(window_name, WND_PROP_AUTOSIZE) >= 0)
     {
         rs2::frameset data = pipe.wait_for_frames(); // Wait for next set of frames from the camera
+        auto start = std::chrono::steady_clock::now();
         rs2::frame depth = data.get_color_frame().apply_filter(color_map);
 
         // Query frame size (width and height)
@@ -37,11 +61,33 @@ int main(int argc, char* argv[]) try
         Mat small_image;
         Mat grayimage;
 
-        resize(image, small_image, Size(200, 200), 0, 0, 1);
+        const int side = cvRound(200 * governor.current().scale);
+        resize(image, small_image, Size(side, side), 0, 0, 1);
         cvtColor(small_image, grayimage, COLOR_BGR2GRAY);
 
-        std::vector<Rect> faces;
-        faceCascade.detectMultiScale(grayimage, faces, 1.1, 3, 0, Size(30, 30));
+        switch (scheduler.next(changes, grayimage))
+        {
+        case detection_scheduler::FULL:
+            faces.clear();
+            faceCascade.detectMultiScale(grayimage, faces, 1.1, 3, 0, Size(30, 30));
+            break;
+
+        case detection_scheduler::ROI:
+        {
+            // Faces outside the changed region are kept, the region is searched again
+            Rect roi = changes.changed_region(grayimage.size(), 15);
+            faces.erase(std::remove_if(faces.begin(), faces.end(),
+                [&](const Rect& f) { return (f & roi).area() > 0; }), faces.end());
+
+            std::vector<Rect> found;
+            faceCascade.detectMultiScale(grayimage(roi), found, 1.1, 3, 0, Size(30, 30));
+            for (Rect f : found) faces.push_back(f + roi.tl());
+            break;
+        }
+
+        case detection_scheduler::SKIP:
+            break;
+        }
 
         for (Rect area : faces)
         {
@@ -52,6 +98,20 @@ int main(int argc, char* argv[]) try
 
         // Update the window with new data1
         imshow(window_name, small_image);
+
+        double frame_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (governor.observe(frame_ms))
+        {
+            auto previous = pipe.get_active_profile().get_stream(RS2_STREAM_COLOR).as<rs2::video_stream_profile>();
+            auto& level = governor.current();
+
+            // A change of processing scale alone needs no restart
+            if (previous.width() != level.color_width || previous.height() != level.color_height || previous.fps() != level.fps)
+            {
+                pipe.stop();
+                pipe.start(make_config(device, level));
+            }
+        }
     }
 
     return EXIT_SUCCESS;
@@ -0,0 +1,429 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+
+#include <librealsense2/rs.hpp> // Include RealSense Cross Platform API
+#include <opencv2/opencv.hpp>   // Include OpenCV API
+#include <opencv2/dnn.hpp>
+#include <vector>
+#include <string>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <pthread.h>
+#include "cv-helpers.hpp"
+#include "dnn-model.hpp"
+
+using namespace std;
+using namespace cv;
+using namespace cv::dnn;
+
+// Usage:
+//   multi_camera [--pin] [--batch N] [--fill-ms T] [dnn options] [serial | file.bag] ...
+//
+// Every argument that is not an option names one source: a live device by
+// serial number, or a recorded .bag file that is replayed. With no sources
+// given, every connected RealSense device is opened. DNN options are the ones
+// taken by parse_dnn_args (--backend, --precision, --threads, --models).
+// The network always runs on min(N, cameras) images; the inference thread
+// waits up to T ms (default 5) for the other cameras before padding.
+
+const size_t inWidth = 300;
+const size_t inHeight = 300;
+const float WHRatio = inWidth / (float)inHeight;
+const float inScaleFactor = 0.007843f;
+const float meanVal = 127.5;
+
+
+// Pin the calling thread to one core. Returns false when pinning is not
+// supported or the core does not exist.
+static bool pin_current_thread(int core)
+{
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(core, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)core;
+    return false;
+#endif
+}
+
+static bool is_replay_file(const string& spec)
+{
+    return spec.size() > 4 && spec.compare(spec.size() - 4, 4, ".bag") == 0;
+}
+
+
+// One pre-processed frame waiting for the network.
+struct inference_request
+{
+    int source;
+    unsigned long long frame_number;
+    Mat blob;       // 1x3xHxW, already scaled and mean subtracted
+    Mat color;      // cropped color image the detections refer to
+    Mat depth;      // cropped depth in meters, aligned to color
+};
+
+struct detection
+{
+    size_t objectClass;
+    float confidence;
+    Rect object;
+    float meters;
+};
+
+
+// Detection requests from every camera feed this single queue. Each source
+// keeps at most one pending request: a newer frame replaces the old one, so
+// a slow network never builds up latency for any camera.
+class inference_queue
+{
+public:
+    void push(inference_request&& req)
+    {
+        {
+            lock_guard<mutex> lock(_mutex);
+            for (auto& pending : _pending)
+            {
+                if (pending.source == req.source)
+                {
+                    pending = std::move(req);
+                    _dropped++;
+                    return;
+                }
+            }
+            _pending.push_back(std::move(req));
+        }
+        _cv.notify_one();
+    }
+
+    // Block until at least one request is pending, then give the other
+    // cameras up to fill_wait to complete the batch, and take up to max_batch.
+    bool pop_batch(size_t max_batch, chrono::milliseconds fill_wait, vector<inference_request>& out)
+    {
+        out.clear();
+        unique_lock<mutex> lock(_mutex);
+        _cv.wait(lock, [this] { return _stopped || !_pending.empty(); });
+        if (_stopped) return false;
+
+        _cv.wait_for(lock, fill_wait, [&] { return _stopped || _pending.size() >= max_batch; });
+        if (_stopped) return false;
+
+        while (!_pending.empty() && out.size() < max_batch)
+        {
+            out.push_back(std::move(_pending.front()));
+            _pending.pop_front();
+        }
+        return true;
+    }
+
+    void stop()
+    {
+        {
+            lock_guard<mutex> lock(_mutex);
+            _stopped = true;
+        }
+        _cv.notify_all();
+    }
+
+    unsigned long long dropped() const { return _dropped; }
+
+private:
+    mutex _mutex;
+    condition_variable _cv;
+    deque<inference_request> _pending;
+    bool _stopped = false;
+    atomic<unsigned long long> _dropped{ 0 };
+};
+
+
+// Per camera state: capture / pre-processing thread and the latest result.
+struct camera_source
+{
+    int index;
+    string spec;
+    int core = -1;
+
+    rs2::pipeline pipe;
+    thread worker;
+
+    mutex result_mutex;
+    Mat result_color;
+    vector<detection> result_detections;
+    bool has_result = false;
+
+    atomic<unsigned long long> processed{ 0 };
+};
+
+
+static void capture_loop(camera_source& src, inference_queue& queue, atomic<bool>& running) try
+{
+    if (src.core >= 0 && !pin_current_thread(src.core))
+        cerr << "source " << src.index << ": could not pin to core " << src.core << endl;
+
+    rs2::config cfg;
+    if (is_replay_file(src.spec))
+        cfg.enable_device_from_file(src.spec);
+    else
+        cfg.enable_device(src.spec);
+
+    auto config = src.pipe.start(cfg);
+    auto profile = config.get_stream(RS2_STREAM_COLOR).as<rs2::video_stream_profile>();
+
+    rs2::align align_to(RS2_STREAM_COLOR);
+
+    Size cropSize;
+    if (profile.width() / (float)profile.height() > WHRatio)
+        cropSize = Size(static_cast<int>(profile.height() * WHRatio), profile.height());
+    else
+        cropSize = Size(profile.width(), static_cast<int>(profile.width() / WHRatio));
+
+    Rect crop(Point((profile.width() - cropSize.width) / 2, (profile.height() - cropSize.height) / 2), cropSize);
+
+    unsigned long long last_frame_number = 0;
+
+    while (running)
+    {
+        rs2::frameset data;
+        if (!src.pipe.try_wait_for_frames(&data, 100)) continue;
+        data = align_to.process(data);
+
+        auto color_frame = data.get_color_frame();
+        auto depth_frame = data.get_depth_frame();
+        if (!color_frame || !depth_frame) continue;
+
+        // If we only received new depth frame, but the color did not update, continue
+        if (color_frame.get_frame_number() == last_frame_number) continue;
+        last_frame_number = color_frame.get_frame_number();
+
+        inference_request req;
+        req.source = src.index;
+        req.frame_number = last_frame_number;
+        req.color = frame_to_mat(color_frame)(crop).clone();
+        req.depth = depth_frame_to_meters(depth_frame)(crop).clone();
+        req.blob = blobFromImage(req.color, inScaleFactor, Size(inWidth, inHeight), meanVal, false);
+
+        queue.push(std::move(req));
+    }
+
+    src.pipe.stop();
+}
+catch (const rs2::error& e)
+{
+    // A failing camera must not take the others down with it
+    std::cerr << "source " << src.index << " (" << src.spec << "): RealSense error calling "
+        << e.get_failed_function() << "(" << e.get_failed_args() << "):\n    " << e.what() << std::endl;
+}
+catch (const std::exception& e)
+{
+    // e.g. cv::Exception from frame_to_mat or blobFromImage
+    std::cerr << "source " << src.index << " (" << src.spec << "): " << e.what() << std::endl;
+}
+
+
+// Single consumer: stacks pending requests into one NCHW batch so the model is
+// loaded once and every camera shares the same forward pass. The batch always
+// has batch_size images, padded with zeros when fewer frames are pending: a
+// changing input shape makes OpenCV DNN reallocate its buffers and the
+// OpenVINO backend rebuild the network on every forward.
+static void inference_loop(Net& net, inference_queue& queue, vector<unique_ptr<camera_source>>& sources,
+    size_t batch_size, chrono::milliseconds fill_wait)
+{
+    vector<inference_request> batch;
+    const float confidenceThreshold = 0.8f;
+
+    int shape[] = { (int)batch_size, 3, (int)inHeight, (int)inWidth };
+    Mat inputBlob(4, shape, CV_32F);
+
+    while (queue.pop_batch(batch_size, fill_wait, batch))
+    {
+        const int n = static_cast<int>(batch.size());
+        for (int i = 0; i < n; i++)
+            memcpy(inputBlob.ptr<float>(i), batch[i].blob.ptr<float>(), batch[i].blob.total() * sizeof(float));
+        for (int i = n; i < (int)batch_size; i++)
+            memset(inputBlob.ptr<float>(i), 0, batch[0].blob.total() * sizeof(float));
+
+        net.setInput(inputBlob);
+        Mat detection_out = net.forward();
+
+        // SSD output is 1x1xKx7; column 0 holds the index of the image in the batch
+        Mat detectionMat(detection_out.size[2], detection_out.size[3], CV_32F, detection_out.ptr<float>());
+
+        vector<vector<detection>> per_image(n);
+        for (int i = 0; i < detectionMat.rows; i++)
+        {
+            int image = static_cast<int>(detectionMat.at<float>(i, 0));
+            float confidence = detectionMat.at<float>(i, 2);
+            if (image < 0 || image >= n || confidence <= confidenceThreshold) continue;
+
+            const Mat& color_mat = batch[image].color;
+            const Mat& depth_mat = batch[image].depth;
+
+            int xLeftBottom = static_cast<int>(detectionMat.at<float>(i, 3) * color_mat.cols);
+            int yLeftBottom = static_cast<int>(detectionMat.at<float>(i, 4) * color_mat.rows);
+            int xRightTop = static_cast<int>(detectionMat.at<float>(i, 5) * color_mat.cols);
+            int yRightTop = static_cast<int>(detectionMat.at<float>(i, 6) * color_mat.rows);
+
+            Rect object(xLeftBottom, yLeftBottom, xRightTop - xLeftBottom, yRightTop - yLeftBottom);
+            object = object & Rect(0, 0, depth_mat.cols, depth_mat.rows);
+            if (object.area() == 0) continue;
+
+            detection d;
+            d.objectClass = (size_t)(detectionMat.at<float>(i, 1));
+            d.confidence = confidence;
+            d.object = object;
+            d.meters = static_cast<float>(mean(depth_mat(object))[0]);
+            per_image[image].push_back(d);
+        }
+
+        for (int i = 0; i < n; i++)
+        {
+            auto& src = *sources[batch[i].source];
+            lock_guard<mutex> lock(src.result_mutex);
+            src.result_color = batch[i].color;
+            src.result_detections = std::move(per_image[i]);
+            src.has_result = true;
+            src.processed++;
+        }
+    }
+}
+
+
+int main(int argc, char* argv[]) try
+{
+    bool pin = false;
+    size_t max_batch = 4;
+    int fill_ms = 5;
+    vector<string> specs;
+
+    dnn_config dnn_cfg;
+    auto args = parse_dnn_args(argc, argv, dnn_cfg);
+
+    for (size_t i = 0; i < args.size(); i++)
+    {
+        if (args[i] == "--pin") pin = true;
+        else if (args[i] == "--batch" && i + 1 < args.size()) max_batch = max(1, atoi(args[++i].c_str()));
+        else if (args[i] == "--fill-ms" && i + 1 < args.size()) fill_ms = max(0, atoi(args[++i].c_str()));
+        else specs.push_back(args[i]);
+    }
+
+    // No sources given: open every connected device
+    if (specs.empty())
+    {
+        rs2::context ctx;
+        for (auto&& dev : ctx.query_devices())
+            specs.push_back(dev.get_info(RS2_CAMERA_INFO_SERIAL_NUMBER));
+    }
+    if (specs.empty())
+    {
+        cerr << "No RealSense devices connected and no replay files given" << endl;
+        return EXIT_FAILURE;
+    }
+
+    // The model is loaded once and shared by every camera
+    Net net = load_dnn_model(dnn_cfg);
+
+    // Each camera has at most one pending frame, so a larger batch is never filled
+    const size_t batch_size = min(max_batch, specs.size());
+
+    // With --pin, capture threads are pinned to cores 1..n-1. The inference
+    // and display threads stay unpinned: OpenCV starts its worker pool from
+    // whichever thread first runs a parallel loop, and the workers inherit
+    // that thread's affinity. A warm-up forward here starts the pool from
+    // the unpinned main thread before any capture thread exists.
+    const int cores = max(1, (int)thread::hardware_concurrency());
+    {
+        int shape[] = { (int)batch_size, 3, (int)inHeight, (int)inWidth };
+        net.setInput(Mat(4, shape, CV_32F, Scalar(0)));
+        net.forward();
+    }
+
+    inference_queue queue;
+    atomic<bool> running{ true };
+    vector<unique_ptr<camera_source>> sources;
+
+    for (size_t i = 0; i < specs.size(); i++)
+    {
+        unique_ptr<camera_source> src(new camera_source);
+        src->index = static_cast<int>(i);
+        src->spec = specs[i];
+        if (pin && cores > 1) src->core = 1 + static_cast<int>(i) % (cores - 1);
+        sources.push_back(std::move(src));
+    }
+
+    for (auto& src : sources)
+        src->worker = thread(capture_loop, std::ref(*src), std::ref(queue), std::ref(running));
+
+    thread inference(inference_loop, std::ref(net), std::ref(queue), std::ref(sources),
+        batch_size, chrono::milliseconds(fill_ms));
+
+    for (auto& src : sources)
+        namedWindow(src->spec, WINDOW_AUTOSIZE);
+
+    auto last_report = chrono::steady_clock::now();
+    unsigned long long last_total = 0;
+
+    while (waitKey(1) < 0)
+    {
+        for (auto& src : sources)
+        {
+            Mat color_mat;
+            vector<detection> detections;
+            {
+                lock_guard<mutex> lock(src->result_mutex);
+                if (!src->has_result) continue;
+                color_mat = src->result_color.clone();
+                detections = src->result_detections;
+            }
+
+            for (auto& d : detections)
+            {
+                std::ostringstream ss;
+                ss << classNames[d.objectClass] << " ";
+                ss << std::setprecision(2) << d.meters << " meters away";
+
+                rectangle(color_mat, d.object, Scalar(0, 255, 0));
+                putText(color_mat, ss.str(), d.object.tl(), FONT_HERSHEY_SIMPLEX, 0.5, Scalar(0, 0, 0));
+            }
+
+            imshow(src->spec, color_mat);
+        }
+
+        // Report aggregate throughput once per second
+        auto now = chrono::steady_clock::now();
+        auto elapsed = chrono::duration<double>(now - last_report).count();
+        if (elapsed >= 1.0)
+        {
+            unsigned long long total = 0;
+            for (auto& src : sources) total += src->processed;
+
+            printf("%zu cameras: %.1f fps aggregate, %llu frames replaced in queue\n",
+                sources.size(), (total - last_total) / elapsed, queue.dropped());
+
+            last_total = total;
+            last_report = now;
+        }
+    }
+
+    running = false;
+    for (auto& src : sources) src->worker.join();
+    queue.stop();
+    inference.join();
+
+    return EXIT_SUCCESS;
+}
+catch (const rs2::error& e)
+{
+    std::cerr << "RealSense error calling " << e.get_failed_function() << "(" << e.get_failed_args() << "):\n    " << e.what() << std::endl;
+    return EXIT_FAILURE;
+}
+catch (const std::exception& e)
+{
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+}
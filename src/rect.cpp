@@ -6,23 +6,21 @@
 #include <opencv4/opencv2/tracking/tracker.hpp>
 #include <vector>
 #include <string>
+#include <algorithm>
 #include <unistd.h>
 #include "cv-helpers.hpp"
+#include "app-steps.hpp"
+#include "latest-frame.hpp"
 
 using namespace std;
 using namespace cv;
+using namespace cv::dnn;
 using namespace rs2;
 
 bool mouse_is_pressing = false;
 int start_x, start_y, end_x, end_y;
 int step = 0;
 
-const size_t inWidth = 300;
-const size_t inHeight = 300;
-const float WHRatio = inWidth / (float)inHeight;
-const float inScaleFactor = 0.007843f;
-const float meanVal = 127.5;
-
 
 void swap(int* v1, int* v2) {
 	int temp = *v1;
@@ -57,45 +55,52 @@ void mouse_callback(int event, int x, int y, int flags, void* userdata)
 }
 
 
+// Usage: rect [--latest] [--backend opencv|openvino] [--precision fp32|fp16|int8] [--threads N] [--models DIR]
+//
+// --latest selects the latency-first capture: only the newest color/depth
+// pair is processed, paired by timestamp, and older frames are dropped.
 int main(int argc, char* argv[]) try
 {
-	// Declare RealSense pipeline, encapsulating the actual device and sensors
-	pipeline pipe;
-	// Start streaming with default recommended configuration
-	auto config = pipe.start();
-	// What is mean as?? 
-	auto profile = config.get_stream(RS2_STREAM_COLOR).as<vidio_stream_profile>();
+	dnn_config dnn_cfg;
+	auto args = parse_dnn_args(argc, argv, dnn_cfg);
+	bool latency_first = find(args.begin(), args.end(), "--latest") != args.end();
 
-	// What is mean align??
-	rs2::align align_to(RS2_STREAM_COLOR);
+	// Detection, gated by change detection, runs in ssd_step (app-steps.hpp),
+	// shared with tracking_regression
+	ssd_step detector(dnn_cfg);
 
-	Size cropSize;
-
-	if (profile.width() / (float)profile.height > WHRatio)
-	{
-		cropSize = Size(static_cast<int>(profile.height() * WHRatio), profile.height());
-	}
-	else
-	{
-		cropSize = Size(profile.width(), static_cast<int>(profile.width() / WHRatio));
-	}
+	latest_frame_pair latest;
 
-	Rect crop(Point((profile.width() - cropSize.width) / 2, (profile.height() - cropSize.height) / 2), cropSize);
+	auto device = first_device();
+	rs2::config cfg = make_config(device, stream_ladder(device, ssd_step::needs()).back());
 
+	// Declare RealSense pipeline, encapsulating the actual device and sensors
+	pipeline pipe;
+	// Start streaming with the negotiated configuration
+	if (latency_first)
+		pipe.start(cfg, [&](rs2::frame f) { latest(f); });
+	else
+		pipe.start(cfg);
 
 	const auto window_name = "Display Image";
-	namedWindow(window_name, WIDOW_AUTOSIZE);
+	namedWindow(window_name, WINDOW_AUTOSIZE);
 
 	// What is the Return value of getWindowProperty function?
 	while (getWindowProperty(window_name, WND_PROP_AUTOSIZE) >= 0)
 	{
 		// Wait for the next set of frames;
-		auto data = pipe.wait_for_frames();
-		// Make sure the frames are spatially alinged
-		data = align_to.process(data);
+		rs2::frameset data;
+		if (latency_first)
+		{
+			// Newest color with a depth frame close in time, never a queued one
+			if (!latest.wait(data)) continue;
+		}
+		else
+		{
+			data = pipe.wait_for_frames();
+		}
 
 		auto color_frame = data.get_color_frame();
-		auto depth_frame = data.get_depth_frame();
 
 		// If we only received new depth framem, but the color did not update, continue
 		static int last_frame_number = 0;
@@ -103,94 +108,35 @@ int main(int argc, char* argv[]) try
 
 		last_frame_number = color_frame.get_frame_number();
 
-		// ----------------------------------------------------------------------------------- //
-		
-		// Convert Realsense frame to OpenCV matrix.
-		// static cv::Mat frame_to_mat( const rs2::frame &f );
-		// static cv::Mat depth_frame_to_meters( const rs2::depth_frame &f );
-		auto color_mat = frame_to_mat(color_frame);	
-		auto depth_mat = depth_frame_to_meters(depth_frame);
-
-		// ----------------------------------------------------------------------------------- //
-		
-		// Convert Mat to batch of images
-		Mat inputBlob = blobFromImage(color_mat, inScaleFactor, Size(inWidth, inHeight), meanVal, false);
-
-		// set the network input
-		net.setInput(inputBlob, "data");
+		// Aligns depth to color, runs the network when the scene changed and
+		// maps the detections into the center crop
+		auto& detections = detector.process(data);
+		Mat color_mat = detector.color();
 
-		// Compute Output ( N-Dimention )
-		Mat detection = net.forward("detection_out");
-
-		// detection.size[2] = detection_cols, detection.size[3] = detection_rows
-		Mat detectionMat(detection.size[2], detection.size[3], CV_32F, detection.ptr<float>());
-
-		// Crop both color and depth frames
-		//
-		// cv::Mat(Rect &r);
-		// Share Memory??
-		color_mat = color_mat(crop);
-		depth_mat = depth_mat(crop);
-
-		// What is the confidenceThreshold ?
-		float confidenceThreshold = 0.8f;
+		for (auto& d : detections)
+		{
+			// Deteced Label and Covert String
+			std::ostringstream ss;
+			ss << classNames[d.object_class] << " ";
+			ss << std::setprecision(2) << d.distance << " meters away";
+			String conf(ss.str());
+
+			rectangle(color_mat, d.rect, Scalar(0, 255, 0));
+			int baseLine = 0;
+			Size labelSize =  getTextSize(ss.str(), FONT_HERSHEY_SIMPLEX, 0.5, 1, &baseLine);
+
+			auto center = (d.rect.br() + d.rect.tl()) * 0.5;
+			
+			center.x = center.x - labelSize.width / 2;
+		}
 
-		for (int i = 0; i < detectionMat.rows; i++)
+		if (latency_first)
 		{
-			float confidence = detectionMat.at<float>(i, 2);
-
-			if (confidence > confidenceThreshold)
-			{
-				size_t objectClass = (size_t)(detectionMat.at<float>(i, 1));
-
-				// Detection Point * Mat Cols, Detection Point * Mat Rows = Detection Rectangle
-				int xLeftBottom = static_cast<int>(detectionMat.at<float>(i, 3) * color_mat.cols);
-				int yLeftBottom = static_cast<int>(detectionMat.at<float>(i, 4) * color_mat.rows);
-				int xRightTop = static_cast<int>(detectionMat.at<float>(i, 5) * color_mat.cols);
-				int yRightTop = static_cast<int>(detectionMat.at<float>(i, 6) * color_mat.rows);
-
-				// Detected Object Rectangle.
-				Rect object((int)xLeftBottom, (int)yLeftBottom, 
-						(int)(xRightTop - xLeftBottom),
-						(int)(yRightTop - yLeftBottom));
-				
-				// Intersection of Union ?
-				object = object & Rect(0, 0, depth_mat.cols, depth_mat.rows);
-
-				// Calculate mean depth inside the detection region.
-				// This is a very naive way to estimate objects depth
-				// but it is intended to demonstrate how one might use depth data in general.
-
-				// Scalar m (B, G, R)
-				// B = m[2];
-				// G = m[1];
-				// R = m[0];
-				Scalar m = mean(depth_mat(object));
-				/*
-				 * static cv::Mat depth_frame_to_meters( const rs2::depth_frame &f )
-				 * {
-				 * 	cv::Mat dm = frame_to_mat(f);
-				 * 	dm.converTo( dm, CV_64F );
-				 * 	dm = dm * f.get_units();
-				 * 	return dm;
-				 * }
-				 *
-				 */
-				// Deteced Label and Covert String
-				std::ostringstream ss;
-				ss << classNames[objectClass] << " ";
-				ss << std::setprecision(2) << m[0] << " meters away";
-				String conf(ss.str());
-
-				rectangle(color_mat, object, Scalar(0, 255, 0));
-				int baseLine = 0;
-				Size labelSize =  getTextSize(ss.str(), FONT_HERSHEY_SIMPLEX, 0.5, 1, &baseLine);
-
-				auto center = (object.br() + object.tl()) * 0.5;
-				
-				center.x = center.x - labelSize.width / 2;
-
-			}
+			std::ostringstream ss;
+			ss << "age " << std::fixed << std::setprecision(1) << latest.age_ms() << " ms, dropped "
+				<< latest.dropped(latest_frame_pair::COLOR) << " color / "
+				<< latest.dropped(latest_frame_pair::DEPTH) << " depth, unpaired " << latest.unpaired();
+			putText(color_mat, ss.str(), Point(5, 15), FONT_HERSHEY_SIMPLEX, 0.4, Scalar(0, 255, 255));
 		}
 
 		imshow(window_name, color_mat);
@@ -0,0 +1,285 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <ctime>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Per-frame tracking results published into a POSIX shared-memory ring.
+//
+// There is one writer (the tracking loop) and any number of readers. The
+// writer never waits for readers: each slot carries a sequence counter that is
+// odd while the slot is being written, so a reader copies the slot and keeps
+// it only if the counter was even and unchanged around the copy. After the
+// segment is mapped, neither side makes a syscall per frame.
+//
+// All latency stamps are CLOCK_MONOTONIC nanoseconds (shm_now_ns), which is
+// shared by every process on the host, so a consumer can subtract them from
+// its own shm_now_ns() to get the age of a result.
+//
+// Only one publisher may use a segment name at a time. A publisher that
+// starts on an existing segment (a second instance, or a restart after a
+// crash left it behind) wipes the ring: write_index drops back to 0 and the
+// header's generation is incremented. Readers must resync when either happens
+// (see shm_consumer.cpp). A publisher that exits normally sets the header's
+// closed flag and unlinks the name, so the next one creates a new segment
+// that existing readers cannot see: readers must reopen by name once
+// stale() reports this.
+
+const uint32_t SHM_MAGIC = 0x54524b31; // "TRK1"
+const uint32_t SHM_VERSION = 3;
+const int SHM_MAX_TARGETS = 16;
+
+struct shm_target
+{
+    int32_t id;
+    float bbox[4];          // x, y, width, height in color pixels
+    float depth;            // robust (median) depth inside bbox, meters
+    float position[3];      // camera-space x, y, z in meters
+};
+
+struct shm_record
+{
+    uint64_t frame_number;
+    double capture_timestamp;   // device timestamp of the frame, ms
+
+    // End-to-end latency stamps, CLOCK_MONOTONIC ns
+    int64_t arrival_ns;         // frame handed to the application
+    int64_t processed_ns;       // tracking / depth for this frame done
+    int64_t published_ns;       // record written to the ring
+
+    int32_t target_count;
+    shm_target targets[SHM_MAX_TARGETS];
+};
+
+struct shm_slot
+{
+    std::atomic<uint64_t> sequence;
+    uint64_t index;                     // ring index held, guards against lapping
+    shm_record record;
+};
+
+struct shm_header
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t capacity;
+    uint32_t record_size;
+    std::atomic<uint32_t> generation;   // incremented every time a publisher (re)starts
+    std::atomic<uint32_t> closed;       // set by the publisher before it unlinks the segment
+    std::atomic<uint64_t> write_index;  // number of records published so far
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared-memory ring needs lock-free 64-bit atomics");
+
+inline int64_t shm_now_ns()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+inline size_t shm_segment_size(uint32_t capacity)
+{
+    return sizeof(shm_header) + capacity * sizeof(shm_slot);
+}
+
+
+class shm_publisher
+{
+public:
+    // Creates (or truncates) the segment /name with room for capacity records.
+    shm_publisher(const std::string& name, uint32_t capacity = 256)
+        : _name(name), _capacity(capacity), _size(shm_segment_size(capacity))
+    {
+        int fd = shm_open(_name.c_str(), O_CREAT | O_RDWR, 0644);
+        if (fd < 0) throw std::runtime_error("shm_open failed for " + _name);
+
+        struct stat st;
+        bool existing = fstat(fd, &st) == 0 && st.st_size == (off_t)_size;
+
+        if (ftruncate(fd, _size) != 0)
+        {
+            close(fd);
+            throw std::runtime_error("ftruncate failed for " + _name);
+        }
+
+        void* mem = mmap(nullptr, _size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (mem == MAP_FAILED) throw std::runtime_error("mmap failed for " + _name);
+
+        _header = static_cast<shm_header*>(mem);
+        _slots = reinterpret_cast<shm_slot*>(_header + 1);
+
+        // Carry the generation over from a previous publisher so readers notice the reset
+        uint32_t generation = 0;
+        if (existing && _header->magic == SHM_MAGIC && _header->version == SHM_VERSION)
+            generation = _header->generation.load(std::memory_order_relaxed) + 1;
+
+        _header->magic = 0;
+        std::atomic_thread_fence(std::memory_order_release);
+        memset(mem, 0, _size);
+        _header->generation.store(generation, std::memory_order_relaxed);
+        _header->capacity = _capacity;
+        _header->record_size = sizeof(shm_record);
+        _header->version = SHM_VERSION;
+        _header->write_index.store(0, std::memory_order_relaxed);
+        // Readers check the magic last, so publish it after everything else
+        std::atomic_thread_fence(std::memory_order_release);
+        _header->magic = SHM_MAGIC;
+    }
+
+    ~shm_publisher()
+    {
+        _header->closed.store(1, std::memory_order_release);
+        munmap(_header, _size);
+        shm_unlink(_name.c_str());
+    }
+
+    shm_publisher(const shm_publisher&) = delete;
+    shm_publisher& operator=(const shm_publisher&) = delete;
+
+    // Fills in published_ns and writes the record into the next slot.
+    void publish(shm_record record)
+    {
+        uint64_t index = _header->write_index.load(std::memory_order_relaxed);
+        shm_slot& slot = _slots[index % _capacity];
+
+        uint64_t seq = slot.sequence.load(std::memory_order_relaxed);
+        slot.sequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        record.published_ns = shm_now_ns();
+        slot.index = index;
+        memcpy(&slot.record, &record, sizeof(record));
+
+        slot.sequence.store(seq + 2, std::memory_order_release);
+        _header->write_index.store(index + 1, std::memory_order_release);
+    }
+
+private:
+    std::string _name;
+    uint32_t _capacity;
+    size_t _size;
+    shm_header* _header;
+    shm_slot* _slots;
+};
+
+
+class shm_reader
+{
+public:
+    explicit shm_reader(const std::string& name)
+    {
+        _fd = shm_open(name.c_str(), O_RDONLY, 0);
+        if (_fd < 0) throw std::runtime_error("shm_open failed for " + name);
+
+        struct stat st;
+        if (fstat(_fd, &st) != 0 || st.st_size < (off_t)sizeof(shm_header))
+        {
+            close(_fd);
+            throw std::runtime_error("segment " + name + " is not initialized");
+        }
+        _size = st.st_size;
+
+        void* mem = mmap(nullptr, _size, PROT_READ, MAP_SHARED, _fd, 0);
+        if (mem == MAP_FAILED)
+        {
+            close(_fd);
+            throw std::runtime_error("mmap failed for " + name);
+        }
+
+        _header = static_cast<const shm_header*>(mem);
+        _slots = reinterpret_cast<const shm_slot*>(_header + 1);
+
+        if (_header->magic != SHM_MAGIC || _header->version != SHM_VERSION ||
+            _header->record_size != sizeof(shm_record) || shm_segment_size(_header->capacity) > _size)
+        {
+            munmap(const_cast<shm_header*>(_header), _size);
+            close(_fd);
+            throw std::runtime_error("segment " + name + " has an incompatible layout");
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+    }
+
+    ~shm_reader()
+    {
+        munmap(const_cast<shm_header*>(_header), _size);
+        close(_fd);
+    }
+
+    shm_reader(const shm_reader&) = delete;
+    shm_reader& operator=(const shm_reader&) = delete;
+
+    // Number of records published so far; record i lives in slot i % capacity.
+    uint64_t write_index() const { return _header->write_index.load(std::memory_order_acquire); }
+    uint32_t capacity() const { return _header->capacity; }
+    uint32_t generation() const { return _header->generation.load(std::memory_order_acquire); }
+
+    // True once this segment will get no more records: its publisher exited,
+    // or the name was unlinked (a publisher that crashed and was cleaned up).
+    // A new publisher uses a new segment, so reopen the reader by name.
+    bool stale() const
+    {
+        if (_header->closed.load(std::memory_order_acquire)) return true;
+        struct stat st;
+        return fstat(_fd, &st) != 0 || st.st_nlink == 0;
+    }
+
+    // Copies record index into out. Fails if it was overwritten or is being
+    // written right now; the caller simply moves on to a newer index.
+    bool read(uint64_t index, shm_record& out) const
+    {
+        if (index >= write_index() || write_index() - index > _header->capacity) return false;
+
+        const shm_slot& slot = _slots[index % _header->capacity];
+        uint64_t before = slot.sequence.load(std::memory_order_acquire);
+        if (before & 1) return false;
+
+        uint64_t held = slot.index;
+        memcpy(&out, &slot.record, sizeof(out));
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        uint64_t after = slot.sequence.load(std::memory_order_relaxed);
+        return before == after && held == index;
+    }
+
+    // Zero-copy access: returns the record in place and its sequence. Use the
+    // fields, then call still_valid(index, sequence) before trusting them.
+    const shm_record* peek(uint64_t index, uint64_t& sequence) const
+    {
+        if (index >= write_index() || write_index() - index > _header->capacity) return nullptr;
+
+        const shm_slot& slot = _slots[index % _header->capacity];
+        sequence = slot.sequence.load(std::memory_order_acquire);
+        if ((sequence & 1) || slot.index != index) return nullptr;
+        return &slot.record;
+    }
+
+    bool still_valid(uint64_t index, uint64_t sequence) const
+    {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const shm_slot& slot = _slots[index % _header->capacity];
+        return slot.sequence.load(std::memory_order_relaxed) == sequence && slot.index == index;
+    }
+
+    bool read_latest(shm_record& out) const
+    {
+        uint64_t end = write_index();
+        return end > 0 && read(end - 1, out);
+    }
+
+private:
+    int _fd;
+    size_t _size;
+    const shm_header* _header;
+    const shm_slot* _slots;
+};
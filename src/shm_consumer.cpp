@@ -0,0 +1,106 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <chrono>
+#include <memory>
+#include "shm-publisher.hpp"
+
+// Minimal downstream consumer: follows the /person_tracking ring published by
+// tracker and prints every target with the age of the result.
+
+// Opens the segment, waiting for a publisher to create it.
+static std::unique_ptr<shm_reader> open_reader(const char* name)
+{
+    while (true)
+    {
+        try
+        {
+            return std::unique_ptr<shm_reader>(new shm_reader(name));
+        }
+        catch (const std::runtime_error&)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+    }
+}
+
+int main(int argc, char* argv[]) try
+{
+    const char* name = argc > 1 ? argv[1] : "/person_tracking";
+    auto reader = open_reader(name);
+
+    uint64_t next = reader->write_index();
+    uint32_t generation = reader->generation();
+
+    while (true)
+    {
+        uint64_t end = reader->write_index();
+
+        // The publisher restarted and wiped the ring: start over from its head
+        if (reader->generation() != generation || end < next)
+        {
+            fprintf(stderr, "publisher restarted, resyncing\n");
+            generation = reader->generation();
+            next = end;
+            continue;
+        }
+
+        if (next == end)
+        {
+            // Idle: check whether the publisher went away (only here, so the
+            // busy path makes no syscalls). Its successor uses a new segment.
+            if (reader->stale())
+            {
+                fprintf(stderr, "publisher exited, reopening %s\n", name);
+                reader.reset();
+                reader = open_reader(name);
+                next = 0;
+                generation = reader->generation();
+                continue;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+
+        // Fell more than a ring behind: skip to the oldest record still there
+        if (end - next > reader->capacity()) next = end - reader->capacity();
+
+        for (; next < end; next++)
+        {
+            uint64_t sequence;
+            const shm_record* record = reader->peek(next, sequence);
+            if (!record) continue;
+
+            // Read in place, then confirm the writer did not touch the slot meanwhile
+            uint64_t frame_number = record->frame_number;
+            int64_t arrival_ns = record->arrival_ns;
+            int64_t published_ns = record->published_ns;
+            int count = record->target_count;
+            shm_target targets[SHM_MAX_TARGETS];
+            for (int i = 0; i < count && i < SHM_MAX_TARGETS; i++) targets[i] = record->targets[i];
+
+            if (!reader->still_valid(next, sequence)) continue;
+
+            double pipeline_ms = (published_ns - arrival_ns) / 1e6;
+            double age_ms = (shm_now_ns() - arrival_ns) / 1e6;
+
+            for (int i = 0; i < count && i < SHM_MAX_TARGETS; i++)
+            {
+                printf("frame %llu id %d depth %.2f m pos (%.2f, %.2f, %.2f) pipeline %.1f ms age %.1f ms\n",
+                    (unsigned long long)frame_number, targets[i].id, targets[i].depth,
+                    targets[i].position[0], targets[i].position[1], targets[i].position[2],
+                    pipeline_ms, age_ms);
+            }
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
+catch (const std::exception& e)
+{
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+}
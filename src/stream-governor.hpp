@@ -0,0 +1,254 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+// Runtime resolution / processing scale governor.
+//
+// The governor walks a ladder of stream levels, cheapest first, to hold the
+// per-frame processing time near a target. It only sees the measured frame
+// times and the ladder, and has no RealSense dependency, so it can be driven
+// by simulated_source as well as by a camera (see stream-profile.hpp).
+// build_stream_ladder() makes the ladder from a list of supported modes, so
+// the simulation and the camera use the same one.
+//
+// Stepping down happens when the smoothed frame time stays above the target
+// for `patience` frames. Stepping up happens when the next level's predicted
+// time still fits under the target with headroom. The prediction scales the
+// part of the frame time above settings.fixed_ms by the ratio of processed
+// pixels. After every change the governor waits `cooldown` frames, since a
+// profile switch restarts the streams.
+
+struct stream_level
+{
+    int color_width, color_height;  // 0 when color is not streamed
+    int depth_width, depth_height;  // 0 when depth is not streamed
+    int fps;
+    double scale;                   // processing scale applied by the app
+    double pixels;                  // pixels the stages process per frame
+
+    // Relative per-frame processing cost: what the stages work on, not what
+    // is captured, since they resize to their needs first
+    double cost() const { return pixels; }
+
+    bool same_streams(const stream_level& o) const
+    {
+        return color_width == o.color_width && color_height == o.color_height &&
+            depth_width == o.depth_width && depth_height == o.depth_height && fps == o.fps;
+    }
+};
+
+// What the processing stages consume; stream-profile.hpp negotiates the
+// smallest modes covering it.
+struct stream_needs
+{
+    int color_width = 0, color_height = 0;  // 0: color not used
+    int depth_width = 0, depth_height = 0;  // 0: depth not used
+    int fps = 30;
+};
+
+struct video_mode
+{
+    int width, height, fps;
+};
+
+// Smallest mode at fps covering width x height; false if there is none.
+static bool smallest_mode(const std::vector<video_mode>& modes, int width, int height, int fps, video_mode& out)
+{
+    bool found = false;
+    for (auto& m : modes)
+    {
+        if (m.fps != fps || m.width < width || m.height < height) continue;
+        if (!found || m.width * m.height < out.width * out.height)
+        {
+            out = m;
+            found = true;
+        }
+    }
+    return found;
+}
+
+// Governor ladder for stages with the given needs, cheapest first.
+//
+// Every level uses the same frame rate, the highest supported one up to
+// needs.fps. The governor measures per-frame time, which a lower frame rate
+// does not reduce, so an fps step would only cost a stream restart. Levels
+// step the processing scale instead, each with the smallest modes covering
+// the needs at that scale, so stepping down shrinks both the captured and the
+// processed images. The last level (scale 1) is the plain negotiated profile.
+static std::vector<stream_level> build_stream_ladder(const std::vector<video_mode>& color_modes,
+    const std::vector<video_mode>& depth_modes, const stream_needs& needs)
+{
+    if (!needs.color_width && !needs.depth_width)
+        throw std::invalid_argument("stream needs neither color nor depth");
+
+    // Highest frame rate at which the full needs are covered
+    int fps = 0;
+    video_mode mode;
+    for (auto& m : needs.color_width ? color_modes : depth_modes)
+    {
+        if (m.fps > needs.fps || m.fps <= fps) continue;
+        if (needs.color_width && !smallest_mode(color_modes, needs.color_width, needs.color_height, m.fps, mode)) continue;
+        if (needs.depth_width && !smallest_mode(depth_modes, needs.depth_width, needs.depth_height, m.fps, mode)) continue;
+        fps = m.fps;
+    }
+    if (!fps) throw std::runtime_error("no stream profile satisfies the configured stages");
+
+    std::vector<stream_level> ladder;
+    for (double scale : { 0.5, 0.625, 0.75, 0.875, 1.0 })
+    {
+        const double scaled = scale * scale;
+        stream_level l = { 0, 0, 0, 0, fps, scale,
+            scaled * ((double)needs.color_width * needs.color_height + (double)needs.depth_width * needs.depth_height) };
+        video_mode color = {}, depth = {};
+        if (needs.color_width)
+        {
+            smallest_mode(color_modes, (int)std::ceil(needs.color_width * scale), (int)std::ceil(needs.color_height * scale), fps, color);
+            l.color_width = color.width;
+            l.color_height = color.height;
+        }
+        if (needs.depth_width)
+        {
+            smallest_mode(depth_modes, (int)std::ceil(needs.depth_width * scale), (int)std::ceil(needs.depth_height * scale), fps, depth);
+            l.depth_width = depth.width;
+            l.depth_height = depth.height;
+        }
+
+        ladder.push_back(l);
+    }
+    return ladder;
+}
+
+
+class frame_time_governor
+{
+public:
+    struct settings
+    {
+        double target_ms = 33.0;
+        double down_above = 1.10;   // step down above target * down_above
+        double up_headroom = 0.85;  // step up if predicted time < target * up_headroom
+        double smoothing = 0.1;     // EWMA weight of a new sample
+        double fixed_ms = 0;        // per-frame time that does not scale with pixels
+        int patience = 15;
+        int cooldown = 30;
+    };
+
+    frame_time_governor(const std::vector<stream_level>& ladder, const settings& s, size_t start)
+        : _ladder(ladder), _s(s), _level(start)
+    {
+        if (_ladder.empty()) throw std::invalid_argument("governor needs at least one stream level");
+        _level = std::min(start, _ladder.size() - 1);
+    }
+
+    // Feeds the processing time of one frame. Returns true when the level
+    // changed and current() must be applied to the source.
+    bool observe(double frame_ms)
+    {
+        _smoothed = _samples++ == 0 ? frame_ms : _smoothed + _s.smoothing * (frame_ms - _smoothed);
+
+        if (_cooldown > 0)
+        {
+            _cooldown--;
+            return false;
+        }
+
+        if (_smoothed > _s.target_ms * _s.down_above)
+        {
+            _over++;
+            _under = 0;
+        }
+        else if (_level + 1 < _ladder.size() &&
+            predicted_ms(_level + 1) < _s.target_ms * _s.up_headroom)
+        {
+            _under++;
+            _over = 0;
+        }
+        else
+        {
+            _over = _under = 0;
+        }
+
+        if (_over >= _s.patience && _level > 0) return step(_level - 1);
+        if (_under >= _s.patience) return step(_level + 1);
+        return false;
+    }
+
+    const stream_level& current() const { return _ladder[_level]; }
+    size_t level() const { return _level; }
+    double smoothed_ms() const { return _smoothed; }
+    unsigned changes() const { return _changes; }
+
+private:
+    // Smoothed time scaled to level `to`, fixed part kept as it is
+    double predicted_ms(size_t to) const
+    {
+        double fixed = std::min(_s.fixed_ms, _smoothed);
+        return fixed + (_smoothed - fixed) * _ladder[to].cost() / _ladder[_level].cost();
+    }
+
+    bool step(size_t to)
+    {
+        // Start the new level from the predicted time rather than the old one
+        _smoothed = predicted_ms(to);
+        _level = to;
+        _over = _under = 0;
+        _cooldown = _s.cooldown;
+        _changes++;
+        return true;
+    }
+
+    std::vector<stream_level> _ladder;
+    settings _s;
+    size_t _level;
+
+    double _smoothed = 0;
+    unsigned long long _samples = 0;
+    int _over = 0, _under = 0, _cooldown = 0;
+    unsigned _changes = 0;
+};
+
+
+// Stand-in for a camera plus processing stages: frame time grows linearly
+// with the level's cost, with jitter and an adjustable load factor to model
+// contention from other processes.
+class simulated_source
+{
+public:
+    simulated_source(double fixed_ms, double ms_per_megapixel, double jitter = 0.1, unsigned seed = 1)
+        : _fixed_ms(fixed_ms), _ms_per_megapixel(ms_per_megapixel), _jitter(jitter), _rng(seed)
+    {
+    }
+
+    void apply(const stream_level& level)
+    {
+        if (!_has_level || !level.same_streams(_level)) _restarts++;
+        _level = level;
+        _has_level = true;
+    }
+
+    void set_load(double factor) { _load = factor; }
+
+    // Processing time of the next frame at the applied level
+    double next_frame_ms()
+    {
+        std::normal_distribution<double> noise(1.0, _jitter);
+        double ms = (_fixed_ms + _ms_per_megapixel * _level.cost() / 1e6) * _load;
+        return std::max(0.0, ms * noise(_rng));
+    }
+
+    unsigned restarts() const { return _restarts; }
+
+private:
+    double _fixed_ms, _ms_per_megapixel, _jitter;
+    double _load = 1.0;
+    std::mt19937 _rng;
+    stream_level _level = {};
+    bool _has_level = false;
+    unsigned _restarts = 0;
+};
@@ -0,0 +1,57 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+
+#pragma once
+
+#include <librealsense2/rs.hpp> // Include RealSense Cross Platform API
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+#include "stream-governor.hpp"
+
+// Stream profile negotiation: instead of pipe.start() with the default
+// profile, each app states what its stages actually consume and only that is
+// captured. A stage that resizes to 200x200 needs no more than the smallest
+// mode covering 200x200.
+
+static std::vector<video_mode> supported_modes(const rs2::device& dev, rs2_stream stream, rs2_format format)
+{
+    std::vector<video_mode> modes;
+    for (auto&& sensor : dev.query_sensors())
+    {
+        for (auto&& profile : sensor.get_stream_profiles())
+        {
+            if (profile.stream_type() != stream || profile.format() != format) continue;
+            if (auto video = profile.as<rs2::video_stream_profile>())
+                modes.push_back({ video.width(), video.height(), video.fps() });
+        }
+    }
+    return modes;
+}
+
+// Governor ladder for dev, see build_stream_ladder(). The highest level is
+// the plain negotiated profile.
+static std::vector<stream_level> stream_ladder(const rs2::device& dev, const stream_needs& needs)
+{
+    return build_stream_ladder(supported_modes(dev, RS2_STREAM_COLOR, RS2_FORMAT_BGR8),
+        supported_modes(dev, RS2_STREAM_DEPTH, RS2_FORMAT_Z16), needs);
+}
+
+// The ladder was built from dev's modes, so the config is pinned to it
+static rs2::config make_config(const rs2::device& dev, const stream_level& level)
+{
+    rs2::config cfg;
+    cfg.enable_device(dev.get_info(RS2_CAMERA_INFO_SERIAL_NUMBER));
+    if (level.color_width)
+        cfg.enable_stream(RS2_STREAM_COLOR, level.color_width, level.color_height, RS2_FORMAT_BGR8, level.fps);
+    if (level.depth_width)
+        cfg.enable_stream(RS2_STREAM_DEPTH, level.depth_width, level.depth_height, RS2_FORMAT_Z16, level.fps);
+    return cfg;
+}
+
+static rs2::device first_device()
+{
+    rs2::context ctx;
+    auto devices = ctx.query_devices();
+    if (devices.size() == 0) throw std::runtime_error("No RealSense device connected");
+    return devices[0];
+}
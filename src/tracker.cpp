@@ -2,12 +2,19 @@
 // Copyright(c) 2017 Intel Corporation. All Rights Reserved.
 
 #include <librealsense2/rs.hpp> // Include RealSense Cross Platform API
+#include <librealsense2/rsutil.h>
 #include <opencv2/opencv.hpp>   // Include OpenCV API
-#include <opencv4/opencv2/tracking/tracker.hpp>
 #include <vector>
 #include <string>
+#include <sstream>
+#include <iomanip>
 #include <unistd.h>
 #include "cv-helpers.hpp"
+#include "app-steps.hpp"
+#include "shm-publisher.hpp"
+#include "depth-proposals.hpp"
+#include "trajectory-store.hpp"
+#include "stream-profile.hpp"
 
 using namespace std;
 using namespace cv;
@@ -50,19 +57,23 @@ void mouse_callback(int event, int x, int y, int flags, void* userdata)
 }
 
 
+// Usage: tracker [--trajectory-log PATH]
+//
+// The target history is appended to PATH, by default
+// trajectory-<date>-<time>.log in the working directory.
 int main(int argc, char* argv[]) try
 {
 	// Declare depth colorizer for pretty visualization of depth data
 	rs2::colorizer color_map;
 	// Declare RealSense pipeline, encapsulating the actual device and sensors
 	rs2::pipeline pipe;
-	// Start streaming with default recommended configuration
-	pipe.start();
+	// Start streaming with the negotiated configuration
+	auto device = first_device();
+	pipe.start(make_config(device, stream_ladder(device, goturn_step::needs()).back()));
 
 	using namespace cv;
 	const auto window_name = "Display Image";
 
-	Mat small_img;
 	Mat rgb_img;
 
 	namedWindow(window_name, WINDOW_AUTOSIZE);
@@ -70,15 +81,26 @@ int main(int argc, char* argv[]) try
 
 	Rect2d bbox;
 
-	Ptr<Tracker> tracker;
-
-	tracker = TrackerGOTURN::create();
+	// GOTURN and the box distance run in goturn_step (app-steps.hpp), shared
+	// with tracking_regression
+	goturn_step tracker;
 
 	bool init_detect = false;
 
+	// Results for the robot controller: /person_tracking in shared memory
+	shm_publisher publisher("/person_tracking");
+
+	// History of the tracked target, also logged to disk for offline analysis
+	trajectory_store trajectories;
+	trajectory_log trajectory_file(trajectory_log_path(argc, argv));
+
+	// Human-sized depth clusters, used to start tracking without a mouse selection
+	depth_proposals proposals;
+
 	while (waitKey(1) < 0 && getWindowProperty(window_name, WND_PROP_AUTOSIZE) >= 0)
 	{
 		rs2::frameset data = pipe.wait_for_frames(); // Wait for next set of frames from the camera
+		int64_t arrival_ns = shm_now_ns();
 		rs2::frame color = data.get_color_frame().apply_filter(color_map);
 		rs2::depth_frame depth = data.get_depth_frame();
 
@@ -96,10 +118,9 @@ int main(int argc, char* argv[]) try
 		Mat image(Size(w, h), CV_8UC3, (void*)color.get_data(), Mat::AUTO_STEP);
 
 
-		resize(image, small_img, Size(width, height));
-
-
-		cvtColor(small_img, rgb_img,COLOR_BGR2RGB);
+		// Resized to the depth resolution for the tracker; overlays are
+		// drawn on a copy
+		tracker.prepare(image, Size(width, height)).copyTo(rgb_img);
 
 	//	printf("color Mat_Col : %d, color Mat_Raw : %d\n", static_cast<int>(color_ma.cols), static_cast<int>(color_ma.rows));		// 1280, 720
 	//	printf("depth Mat_Col : %d, depth Mat_Raw : %d\n", static_cast<int>(depth_ma.cols), static_cast<int>(depth_ma.rows));		// 640, 480
@@ -110,6 +131,30 @@ int main(int argc, char* argv[]) try
 			string text = "Not Detected!";
 			putText(rgb_img, text, Point(400, 80), 1, 1.4, Scalar(255, 255, 0), 2);
 
+			// Proposal ROIs come in color pixels; rgb_img is the color image
+			// resized to the depth resolution, so scale them down to it
+			auto& candidates = proposals.process(depth, data.get_color_frame().get_profile().as<rs2::video_stream_profile>());
+			const double sx = rgb_img.cols / (double)w, sy = rgb_img.rows / (double)h;
+			auto to_rgb_img = [&](const Rect& r)
+			{
+				return Rect2d(r.x * sx, r.y * sy, r.width * sx, r.height * sy);
+			};
+
+			std::ostringstream proposal_text;
+			proposal_text << candidates.size() << " proposals in " << std::fixed << std::setprecision(1)
+				<< proposals.last_ms() << " ms";
+			putText(rgb_img, proposal_text.str(), Point(5, 15), FONT_HERSHEY_SIMPLEX, 0.4, Scalar(0, 255, 255));
+
+			// Nothing selected yet: follow the nearest candidate
+			if (step == 0 && !candidates.empty())
+			{
+				bbox = to_rgb_img(candidates.front().roi);
+				init_detect = tracker.init(bbox);
+			}
+
+			for (auto& p : candidates)
+				rectangle(rgb_img, to_rgb_img(p.roi), Scalar(0, 255, 255), 1);
+
 			switch (step)
 			{
 				case 1:
@@ -128,7 +173,7 @@ int main(int argc, char* argv[]) try
 
 					Rect2d roi(start_x, start_y, end_x - start_x, end_y - start_y);
 					bbox = roi;
-					init_detect = tracker->init(rgb_img, bbox);
+					init_detect = tracker.init(bbox);
 					if (init_detect == true)
 					{
 						string text = "Detected!";
@@ -140,7 +185,13 @@ int main(int argc, char* argv[]) try
 			}
 		}
 
-		bool ok = tracker->update(rgb_img, bbox);
+		float target_depth = 0.f;
+		bool ok = tracker.update(depth_ma, bbox, target_depth);
+
+		shm_record record = {};
+		record.frame_number = depth.get_frame_number();
+		record.capture_timestamp = depth.get_timestamp();
+		record.arrival_ns = arrival_ns;
 
 		if (ok)
 		{
@@ -157,10 +208,37 @@ int main(int argc, char* argv[]) try
 			std::string dist_text(std::to_string(dist_to_center));
 
 			putText(rgb_img, dist_text, Point(400, 80), 1, 1.4, Scalar(145, 145, 3), 2);
+
+			// rgb_img is resized to the depth resolution, so bbox is in depth pixels
+			auto intrin = depth.get_profile().as<rs2::video_stream_profile>().get_intrinsics();
+			float pixel[2] = { dist_to_width, dist_to_height };
+
+			shm_target& target = record.targets[record.target_count++];
+			target.id = 0;
+			// Published boxes are in color pixels: scale back from rgb_img
+			const float sx = w / width, sy = h / height;
+			target.bbox[0] = bbox.x * sx;
+			target.bbox[1] = bbox.y * sy;
+			target.bbox[2] = bbox.width * sx;
+			target.bbox[3] = bbox.height * sy;
+			target.depth = target_depth;
+			rs2_deproject_pixel_to_point(target.position, &intrin, pixel, target.depth);
+
+			trajectory_record history;
+			history.timestamp = record.capture_timestamp;
+			history.id = target.id;
+			memcpy(history.bbox, target.bbox, sizeof(history.bbox));
+			memcpy(history.position, target.position, sizeof(history.position));
+			history.confidence = 1.f;	// GOTURN reports no score, only success
+			trajectories.append(history);
+			trajectory_file.push(history);
 		}
 
 		//printf("%.2f\n", dist_to_center);
 
+		record.processed_ns = shm_now_ns();
+		publisher.publish(record);
+
 
 		imshow(window_name, rgb_img);
 	}
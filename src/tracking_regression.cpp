@@ -0,0 +1,449 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+
+#include <librealsense2/rs.hpp> // Include RealSense Cross Platform API
+#include <opencv2/opencv.hpp>   // Include OpenCV API
+#include <vector>
+#include <string>
+#include <map>
+#include <set>
+#include <atomic>
+#include <memory>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <tuple>
+#include <cmath>
+#include "cv-helpers.hpp"
+#include "app-steps.hpp"
+#include "latest-frame.hpp"
+
+using namespace std;
+using namespace cv;
+using namespace cv::dnn;
+
+// Usage:
+//   tracking_regression <file.bag> <ground_truth.csv> --app tracker|rect|fixed
+//       [--latest] [--min-fps F] [--max-p95-ms T] [--min-mota M] [--min-iou I]
+//       [--max-id-switches N] [--max-depth-error E] [dnn options]
+//
+// Replays a recorded color+depth sequence (not real time) through the
+// per-frame processing of one of the apps and scores it against ground truth.
+// The processing is the apps' own, from app-steps.hpp, so change detection
+// gating and every other step change is measured too. Accuracy and
+// throughput are always printed together; the exit code is non-zero when any
+// given threshold is missed, so the harness can gate optimizations.
+//
+//   tracker  goturn_step started on a ground-truth box (tracker.cpp)
+//   rect     ssd_step person detections, IDs from frame-to-frame IoU
+//            association (rect.cpp)
+//   fixed    a ground-truth box kept in place, center_distance
+//            (2021-03-16.cpp)
+//
+// tracker and fixed take their box from the first frame with ground truth,
+// and again whenever a new ground-truth id appears while they report nothing.
+//
+// --latest captures through latest_frame_pair like rect --latest, with the
+// recording played back in real time: frames the processing cannot keep up
+// with are dropped and count as misses. Without it every frame is processed.
+//
+// Stream profiles are fixed by the recording. To measure an app with its
+// negotiated profile, record with the resolutions it reports as needs (the
+// harness prints them next to the recorded ones).
+//
+// Ground truth CSV, one line per target and frame, '#' starts a comment:
+//   frame,id,x,y,width,height,distance_m
+// frame is the color frame number minus the first one of the recording (the
+// replay index when nothing was dropped while recording); boxes are in color
+// pixels.
+
+struct box
+{
+    int id;
+    Rect2d rect;
+    float distance;
+};
+
+typedef map<int, vector<box>> ground_truth;
+
+static ground_truth load_ground_truth(const string& path)
+{
+    ifstream in(path);
+    if (!in) throw runtime_error("cannot open " + path);
+
+    ground_truth gt;
+    string line;
+    while (getline(in, line))
+    {
+        if (line.empty() || line[0] == '#') continue;
+        replace(line.begin(), line.end(), ',', ' ');
+
+        istringstream ss(line);
+        int frame;
+        box b;
+        if (!(ss >> frame >> b.id >> b.rect.x >> b.rect.y >> b.rect.width >> b.rect.height >> b.distance))
+            throw runtime_error("malformed ground truth line: " + line);
+        gt[frame].push_back(b);
+    }
+    return gt;
+}
+
+static double iou(const Rect2d& a, const Rect2d& b)
+{
+    double inter = (a & b).area();
+    double uni = a.area() + b.area() - inter;
+    return uni > 0 ? inter / uni : 0.0;
+}
+
+
+// Per-frame processing of one app. data is the frameset as recorded; boxes
+// are returned in color pixels.
+class app_adapter
+{
+public:
+    virtual ~app_adapter() {}
+    virtual stream_needs needs() const = 0;
+    virtual void init(const rs2::frameset& data, const vector<box>& first) = 0;
+    virtual vector<box> process(const rs2::frameset& data) = 0;
+};
+
+// Color to depth pixel scale: tracker.cpp and 2021-03-16.cpp work on images
+// of the depth resolution
+static Point2d color_to_depth_scale(const rs2::frameset& data)
+{
+    auto color = data.get_color_frame();
+    auto depth = data.get_depth_frame();
+    return Point2d(depth.get_width() / (double)color.get_width(), depth.get_height() / (double)color.get_height());
+}
+
+static Rect2d scaled(const Rect2d& r, const Point2d& s)
+{
+    return Rect2d(r.x * s.x, r.y * s.y, r.width * s.x, r.height * s.y);
+}
+
+class tracker_app : public app_adapter
+{
+public:
+    stream_needs needs() const override { return goturn_step::needs(); }
+
+    void init(const rs2::frameset& data, const vector<box>& first) override
+    {
+        if (first.empty()) return;
+        prepare(data);
+        _bbox = scaled(first.front().rect, _scale);
+        _step.init(_bbox);
+    }
+
+    vector<box> process(const rs2::frameset& data) override
+    {
+        Mat depth_meters = prepare(data);
+        float distance = 0.f;
+        if (!_step.update(depth_meters, _bbox, distance)) return {};
+        return { { 0, scaled(_bbox, Point2d(1 / _scale.x, 1 / _scale.y)), distance } };
+    }
+
+private:
+    Mat prepare(const rs2::frameset& data)
+    {
+        auto depth = data.get_depth_frame();
+        _scale = color_to_depth_scale(data);
+        _step.prepare(frame_to_mat(data.get_color_frame()), Size(depth.get_width(), depth.get_height()));
+        return depth_frame_to_meters(depth);
+    }
+
+    goturn_step _step;
+    Rect2d _bbox;
+    Point2d _scale;
+};
+
+class fixed_box_app : public app_adapter
+{
+public:
+    // 2021-03-16.cpp starts the pipeline with the default profile
+    stream_needs needs() const override { return stream_needs(); }
+
+    void init(const rs2::frameset&, const vector<box>& first) override
+    {
+        if (!first.empty()) _bbox = first.front().rect;
+    }
+
+    vector<box> process(const rs2::frameset& data) override
+    {
+        if (_bbox.area() <= 0) return {};
+        return { { 0, _bbox, center_distance(data.get_depth_frame(), scaled(_bbox, color_to_depth_scale(data))) } };
+    }
+
+private:
+    Rect2d _bbox;
+};
+
+class rect_app : public app_adapter
+{
+public:
+    explicit rect_app(const dnn_config& cfg) : _step(cfg) {}
+
+    stream_needs needs() const override { return ssd_step::needs(); }
+
+    void init(const rs2::frameset&, const vector<box>&) override {}
+
+    vector<box> process(const rs2::frameset& data) override
+    {
+        const size_t personClass = 15;
+
+        vector<box> current;
+        for (auto& d : _step.process(data))
+        {
+            if (d.object_class != personClass) continue;
+            Rect2d r = d.rect;
+            r.x += _step.crop().x;
+            r.y += _step.crop().y;
+            current.push_back({ -1, r, d.distance });
+        }
+
+        // rect.cpp has no identities: carry IDs over from the previous frame by IoU
+        for (auto& c : current)
+        {
+            double best = 0.3;
+            for (auto& p : _previous)
+            {
+                double v = iou(c.rect, p.rect);
+                if (v > best) { best = v; c.id = p.id; }
+            }
+        }
+        for (auto& c : current)
+            if (c.id < 0) c.id = _next_id++;
+
+        _previous = current;
+        return current;
+    }
+
+private:
+    ssd_step _step;
+    vector<box> _previous;
+    int _next_id = 0;
+};
+
+
+struct thresholds
+{
+    double min_fps = 0;
+    double max_p95_ms = 0;
+    double min_mota = -1e9;
+    double min_iou = 0;
+    long max_id_switches = -1;
+    double max_depth_error = 0;
+};
+
+static double percentile(vector<double> values, double p)
+{
+    if (values.empty()) return 0;
+    size_t k = min(values.size() - 1, (size_t)(p / 100.0 * values.size()));
+    nth_element(values.begin(), values.begin() + k, values.end());
+    return values[k];
+}
+
+
+int main(int argc, char* argv[]) try
+{
+    dnn_config dnn_cfg;
+    auto args = parse_dnn_args(argc, argv, dnn_cfg);
+
+    string bag, gt_path, app = "tracker";
+    bool latency_first = false;
+    thresholds limits;
+    vector<string> positional;
+    for (size_t i = 0; i < args.size(); i++)
+    {
+        const string& a = args[i];
+        bool has_value = i + 1 < args.size();
+        if (a == "--app" && has_value) app = args[++i];
+        else if (a == "--latest") latency_first = true;
+        else if (a == "--min-fps" && has_value) limits.min_fps = atof(args[++i].c_str());
+        else if (a == "--max-p95-ms" && has_value) limits.max_p95_ms = atof(args[++i].c_str());
+        else if (a == "--min-mota" && has_value) limits.min_mota = atof(args[++i].c_str());
+        else if (a == "--min-iou" && has_value) limits.min_iou = atof(args[++i].c_str());
+        else if (a == "--max-id-switches" && has_value) limits.max_id_switches = atol(args[++i].c_str());
+        else if (a == "--max-depth-error" && has_value) limits.max_depth_error = atof(args[++i].c_str());
+        else positional.push_back(a);
+    }
+    if (positional.size() != 2)
+    {
+        cerr << "Usage: tracking_regression <file.bag> <ground_truth.csv> --app tracker|rect|fixed [--latest] [thresholds]" << endl;
+        return EXIT_FAILURE;
+    }
+    bag = positional[0];
+    gt_path = positional[1];
+
+    ground_truth gt = load_ground_truth(gt_path);
+
+    unique_ptr<app_adapter> adapter;
+    if (app == "tracker") adapter.reset(new tracker_app);
+    else if (app == "rect") adapter.reset(new rect_app(dnn_cfg));
+    else if (app == "fixed") adapter.reset(new fixed_box_app);
+    else throw runtime_error("unknown app " + app);
+
+    rs2::pipeline pipe;
+    rs2::config cfg;
+    cfg.enable_device_from_file(bag, false);
+    // Ground-truth frame indices count from the first color frame of the
+    // recording, noted as it arrives: --latest may drop it before pairing
+    latest_frame_pair latest;
+    atomic<long long> first_color{ -1 };
+    auto note_first_color = [&](const rs2::frame& f)
+    {
+        rs2::frame color = f;
+        if (auto fs = f.as<rs2::frameset>()) color = fs.get_color_frame();
+        if (!color || color.get_profile().stream_type() != RS2_STREAM_COLOR) return;
+        long long none = -1;
+        first_color.compare_exchange_strong(none, (long long)color.get_frame_number());
+    };
+    auto config = latency_first
+        ? pipe.start(cfg, [&](rs2::frame f) { note_first_color(f); latest(f); })
+        : pipe.start(cfg);
+    // Without --latest every frame is processed, however long it takes
+    config.get_device().as<rs2::playback>().set_real_time(latency_first);
+
+    auto needs = adapter->needs();
+    auto recorded_color = config.get_stream(RS2_STREAM_COLOR).as<rs2::video_stream_profile>();
+    auto recorded_depth = config.get_stream(RS2_STREAM_DEPTH).as<rs2::video_stream_profile>();
+    printf("recorded color %dx%d, depth %dx%d @ %d fps; app needs color %dx%d, depth %dx%d\n",
+        recorded_color.width(), recorded_color.height(), recorded_depth.width(), recorded_depth.height(),
+        recorded_color.fps(), needs.color_width, needs.color_height, needs.depth_width, needs.depth_height);
+
+    long gt_count = 0, misses = 0, false_positives = 0, id_switches = 0, matches = 0;
+    double iou_sum = 0, depth_error_sum = 0;
+    long depth_samples = 0;
+    map<int, int> last_match;      // ground-truth id -> hypothesis id
+    set<int> seen_ids;             // ground-truth ids so far
+    bool initialized = false, previous_empty = true;
+    vector<double> latency;
+
+    // The ground-truth frame index comes from the color frame number, so it
+    // holds when frames are dropped. Framesets that repeat a color frame
+    // (depth arrived alone) are skipped, as the apps do.
+    int frame = -1, processed = 0;
+    unsigned long long last_color = 0;
+    rs2::frameset data;
+    while (latency_first ? latest.wait(data, 1000) : pipe.try_wait_for_frames(&data, 1000))
+    {
+        auto start = chrono::steady_clock::now();
+
+        if (!latency_first) note_first_color(data);
+        auto color_frame = data.get_color_frame();
+        auto depth_frame = data.get_depth_frame();
+        if (!color_frame || !depth_frame) continue;
+
+        unsigned long long number = color_frame.get_frame_number();
+        if (frame >= 0 && number <= last_color) continue;
+        last_color = number;
+
+        // Frames dropped by --latest, or without a depth partner, still count:
+        // their ground truth is missed
+        int index = static_cast<int>(number - first_color.load());
+        for (int skipped = frame + 1; skipped < index; skipped++)
+        {
+            if (!gt.count(skipped)) continue;
+            misses += gt[skipped].size();
+            gt_count += gt[skipped].size();
+        }
+        frame = index;
+
+        // The single-target apps start from a ground-truth box: on the first
+        // frame that has one, and again when a new target shows up while the
+        // app reports nothing
+        const vector<box>& truth = gt.count(frame) ? gt[frame] : vector<box>();
+        bool new_target = false;
+        for (auto& b : truth) new_target |= seen_ids.insert(b.id).second;
+        if (!truth.empty() && (!initialized || (new_target && previous_empty)))
+        {
+            adapter->init(data, truth);
+            initialized = true;
+        }
+        vector<box> hyp = adapter->process(data);
+        previous_empty = hyp.empty();
+        processed++;
+
+        latency.push_back(chrono::duration<double, milli>(chrono::steady_clock::now() - start).count());
+
+        // Greedy matching at IoU >= 0.5, best pairs first
+        vector<tuple<double, size_t, size_t>> pairs;
+        for (size_t g = 0; g < truth.size(); g++)
+            for (size_t h = 0; h < hyp.size(); h++)
+            {
+                double v = iou(truth[g].rect, hyp[h].rect);
+                if (v >= 0.5) pairs.emplace_back(v, g, h);
+            }
+        sort(pairs.rbegin(), pairs.rend());
+
+        vector<bool> gt_used(truth.size(), false), hyp_used(hyp.size(), false);
+        for (auto& p : pairs)
+        {
+            size_t g = get<1>(p), h = get<2>(p);
+            if (gt_used[g] || hyp_used[h]) continue;
+            gt_used[g] = hyp_used[h] = true;
+
+            matches++;
+            iou_sum += get<0>(p);
+
+            auto last = last_match.find(truth[g].id);
+            if (last != last_match.end() && last->second != hyp[h].id) id_switches++;
+            last_match[truth[g].id] = hyp[h].id;
+
+            if (truth[g].distance > 0 && hyp[h].distance > 0)
+            {
+                depth_error_sum += fabs(hyp[h].distance - truth[g].distance);
+                depth_samples++;
+            }
+        }
+
+        gt_count += truth.size();
+        misses += count(gt_used.begin(), gt_used.end(), false);
+        false_positives += count(hyp_used.begin(), hyp_used.end(), false);
+    }
+    pipe.stop();
+
+    if (latency.empty()) throw runtime_error(bag + ": no frames replayed");
+
+    double total_ms = 0;
+    for (double v : latency) total_ms += v;
+
+    double fps = 1000.0 * latency.size() / total_ms;
+    double p50 = percentile(latency, 50), p95 = percentile(latency, 95), p99 = percentile(latency, 99);
+    double mota = gt_count ? 1.0 - (double)(misses + false_positives + id_switches) / gt_count : 1.0;
+    double mean_iou = matches ? iou_sum / matches : 0.0;
+    double depth_error = depth_samples ? depth_error_sum / depth_samples : 0.0;
+
+    printf("app %s, %d of %d frames processed, %ld ground-truth boxes\n", app.c_str(), processed, frame + 1, gt_count);
+    printf("throughput  %.1f fps, latency p50 %.2f ms, p95 %.2f ms, p99 %.2f ms\n", fps, p50, p95, p99);
+    printf("accuracy    MOTA %.3f, mean IoU %.3f, misses %ld, false positives %ld, ID switches %ld, depth error %.3f m\n",
+        mota, mean_iou, misses, false_positives, id_switches, depth_error);
+
+    vector<string> failures;
+    if (limits.min_fps > 0 && fps < limits.min_fps) failures.push_back("fps");
+    if (limits.max_p95_ms > 0 && p95 > limits.max_p95_ms) failures.push_back("p95 latency");
+    if (mota < limits.min_mota) failures.push_back("MOTA");
+    if (mean_iou < limits.min_iou) failures.push_back("mean IoU");
+    if (limits.max_id_switches >= 0 && id_switches > limits.max_id_switches) failures.push_back("ID switches");
+    if (limits.max_depth_error > 0 && depth_error > limits.max_depth_error) failures.push_back("depth error");
+
+    if (!failures.empty())
+    {
+        cerr << "REGRESSION:";
+        for (auto& f : failures) cerr << " " << f;
+        cerr << endl;
+        return EXIT_FAILURE;
+    }
+
+    printf("PASS\n");
+    return EXIT_SUCCESS;
+}
+catch (const rs2::error& e)
+{
+    std::cerr << "RealSense error calling " << e.get_failed_function() << "(" << e.get_failed_args() << "):\n    " << e.what() << std::endl;
+    return EXIT_FAILURE;
+}
+catch (const std::exception& e)
+{
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+}
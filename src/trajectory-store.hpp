@@ -0,0 +1,415 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <climits>
+#include <ctime>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Per-target trajectory history.
+//
+// trajectory_store keeps the last `capacity` records of every target in a ring
+// allocated once when the target first appears, stored as one array per field
+// (struct of arrays) so scans touch only the fields they need. Records must be
+// appended in timestamp order per target, which keeps every ring sorted:
+// time-range queries are a binary search. A coarse floor grid (x, z) remembers
+// which targets visited each cell and when, for "who was near X" queries.
+// The store is meant to be used from the frame loop thread only.
+//
+// trajectory_log appends the same records to a memory-mapped file on a
+// background thread; the frame loop only pushes into a lock-free queue. An
+// existing file is continued, not truncated, so use one file per process.
+// If the file cannot grow, logging stops and the records are counted as
+// failed instead of taking the writer thread down.
+
+struct trajectory_record
+{
+    double timestamp;       // ms, frame timestamp
+    int32_t id;
+    float bbox[4];          // x, y, width, height in pixels
+    float position[3];      // camera-space x, y, z in meters
+    float confidence;
+};
+
+
+class trajectory_store
+{
+public:
+    explicit trajectory_store(size_t capacity = 1024, float cell_size = 0.5f)
+        : _capacity(capacity), _cell_size(cell_size)
+    {
+    }
+
+    // Returns false, storing nothing, if r is older than the target's last record.
+    bool append(const trajectory_record& r)
+    {
+        auto it = _tracks.find(r.id);
+        if (it == _tracks.end()) it = _tracks.emplace(r.id, track(_capacity)).first;
+        track& t = it->second;
+
+        if (t.count > 0 && r.timestamp < t.timestamp[t.physical(t.count - 1)]) return false;
+
+        size_t slot = t.count < _capacity ? t.physical(t.count) : t.start;
+        t.timestamp[slot] = r.timestamp;
+        for (int i = 0; i < 4; i++) t.bbox[i][slot] = r.bbox[i];
+        for (int i = 0; i < 3; i++) t.position[i][slot] = r.position[i];
+        t.confidence[slot] = r.confidence;
+
+        if (t.count < _capacity) t.count++;
+        else t.start = (t.start + 1) % _capacity;
+
+        index(r);
+
+        if (++_appends % 4096 == 0) prune();
+        return true;
+    }
+
+    // Records of target id with t0 <= timestamp <= t1, oldest first.
+    void query(int id, double t0, double t1, std::vector<trajectory_record>& out) const
+    {
+        out.clear();
+        auto it = _tracks.find(id);
+        if (it == _tracks.end()) return;
+        const track& t = it->second;
+
+        for (size_t i = t.lower_bound(t0); i < t.count; i++)
+        {
+            size_t slot = t.physical(i);
+            if (t.timestamp[slot] > t1) break;
+            out.push_back(t.record(id, slot));
+        }
+    }
+
+    // Latest record of target id; false if the target is unknown.
+    bool latest(int id, trajectory_record& out) const
+    {
+        auto it = _tracks.find(id);
+        if (it == _tracks.end() || it->second.count == 0) return false;
+        out = it->second.record(id, it->second.physical(it->second.count - 1));
+        return true;
+    }
+
+    // Targets that were within radius meters of (x, z) on the floor plane at
+    // some time in [t0, t1]. Candidates come from the grid, then are checked
+    // against their records.
+    std::vector<int> near(float x, float z, float radius, double t0, double t1) const
+    {
+        std::vector<int> candidates;
+        int cx0 = cell(x - radius), cx1 = cell(x + radius);
+        int cz0 = cell(z - radius), cz1 = cell(z + radius);
+
+        for (int cz = cz0; cz <= cz1; cz++)
+        {
+            for (int cx = cx0; cx <= cx1; cx++)
+            {
+                auto it = _grid.find(key(cx, cz));
+                if (it == _grid.end()) continue;
+                for (auto& v : it->second)
+                    if (v.last >= t0 && v.first <= t1) candidates.push_back(v.id);
+            }
+        }
+
+        std::sort(candidates.begin(), candidates.end());
+        candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+        std::vector<int> result;
+        const float r2 = radius * radius;
+        for (int id : candidates)
+        {
+            const track& t = _tracks.at(id);
+            for (size_t i = t.lower_bound(t0); i < t.count; i++)
+            {
+                size_t slot = t.physical(i);
+                if (t.timestamp[slot] > t1) break;
+                float dx = t.position[0][slot] - x;
+                float dz = t.position[2][slot] - z;
+                if (dx * dx + dz * dz <= r2)
+                {
+                    result.push_back(id);
+                    break;
+                }
+            }
+        }
+        return result;
+    }
+
+    std::vector<int> targets() const
+    {
+        std::vector<int> ids;
+        for (auto& t : _tracks) ids.push_back(t.first);
+        return ids;
+    }
+
+    // Floor-grid visits currently held; bounded by pruning
+    size_t visits() const
+    {
+        size_t n = 0;
+        for (auto& cell : _grid) n += cell.second.size();
+        return n;
+    }
+
+private:
+    struct track
+    {
+        explicit track(size_t capacity)
+            : timestamp(capacity), confidence(capacity)
+        {
+            for (auto& b : bbox) b.resize(capacity);
+            for (auto& p : position) p.resize(capacity);
+        }
+
+        size_t physical(size_t logical) const { return (start + logical) % timestamp.size(); }
+
+        // First logical index with timestamp >= t
+        size_t lower_bound(double t) const
+        {
+            size_t lo = 0, hi = count;
+            while (lo < hi)
+            {
+                size_t mid = (lo + hi) / 2;
+                if (timestamp[physical(mid)] < t) lo = mid + 1;
+                else hi = mid;
+            }
+            return lo;
+        }
+
+        trajectory_record record(int id, size_t slot) const
+        {
+            trajectory_record r;
+            r.timestamp = timestamp[slot];
+            r.id = id;
+            for (int i = 0; i < 4; i++) r.bbox[i] = bbox[i][slot];
+            for (int i = 0; i < 3; i++) r.position[i] = position[i][slot];
+            r.confidence = confidence[slot];
+            return r;
+        }
+
+        double oldest() const { return count ? timestamp[start] : 0; }
+
+        std::vector<double> timestamp;
+        std::vector<float> bbox[4];
+        std::vector<float> position[3];
+        std::vector<float> confidence;
+        size_t start = 0;
+        size_t count = 0;
+        int64_t last_cell = INT64_MIN;
+    };
+
+    // A stay of one target in one grid cell
+    struct visit
+    {
+        int id;
+        double first;
+        double last;
+    };
+
+    int cell(float v) const { return static_cast<int>(std::floor(v / _cell_size)); }
+    static int64_t key(int cx, int cz)
+    {
+        return static_cast<int64_t>((static_cast<uint64_t>(static_cast<uint32_t>(cx)) << 32) | static_cast<uint32_t>(cz));
+    }
+
+    void index(const trajectory_record& r)
+    {
+        track& t = _tracks.at(r.id);
+        int64_t k = key(cell(r.position[0]), cell(r.position[2]));
+        auto& visits = _grid[k];
+
+        // Still in the same cell: extend the current visit
+        if (k == t.last_cell)
+        {
+            for (auto v = visits.rbegin(); v != visits.rend(); ++v)
+            {
+                if (v->id == r.id)
+                {
+                    v->last = r.timestamp;
+                    return;
+                }
+            }
+        }
+
+        visits.push_back({ r.id, r.timestamp, r.timestamp });
+        t.last_cell = k;
+    }
+
+    // Drops visits that ended before the oldest record still in their ring.
+    void prune()
+    {
+        for (auto it = _grid.begin(); it != _grid.end();)
+        {
+            auto& visits = it->second;
+            visits.erase(std::remove_if(visits.begin(), visits.end(), [this](const visit& v)
+            {
+                return v.last < _tracks.at(v.id).oldest();
+            }), visits.end());
+
+            if (visits.empty()) it = _grid.erase(it);
+            else ++it;
+        }
+    }
+
+    size_t _capacity;
+    float _cell_size;
+    unsigned long long _appends = 0;
+    std::unordered_map<int, track> _tracks;
+    std::unordered_map<int64_t, std::vector<visit>> _grid;
+};
+
+
+// Log path for an app: the value of --trajectory-log if given, otherwise
+// trajectory-YYYYmmdd-HHMMSS.log in the working directory.
+static std::string trajectory_log_path(int argc, char* argv[])
+{
+    for (int i = 1; i + 1 < argc; i++)
+        if (std::string(argv[i]) == "--trajectory-log") return argv[i + 1];
+
+    char name[64];
+    std::time_t now = std::time(nullptr);
+    std::strftime(name, sizeof(name), "trajectory-%Y%m%d-%H%M%S.log", std::localtime(&now));
+    return name;
+}
+
+class trajectory_log
+{
+public:
+    explicit trajectory_log(const std::string& path, size_t queue_size = 4096)
+        : _queue(queue_size)
+    {
+        _fd = open(path.c_str(), O_CREAT | O_RDWR, 0644);
+        if (_fd < 0) throw std::runtime_error("cannot open " + path);
+
+        // Append after the whole records already there
+        struct stat st;
+        if (fstat(_fd, &st) != 0)
+        {
+            close(_fd);
+            throw std::runtime_error("cannot stat " + path);
+        }
+        _written = static_cast<size_t>(st.st_size) / sizeof(trajectory_record);
+
+        size_t records = 1 << 16;
+        while (records <= _written) records *= 2;
+        try
+        {
+            remap(records);
+        }
+        catch (...)
+        {
+            close(_fd);
+            throw;
+        }
+
+        _writer = std::thread([this] { write_loop(); });
+    }
+
+    ~trajectory_log()
+    {
+        _running = false;
+        _writer.join();
+
+        if (_map) munmap(_map, _mapped * sizeof(trajectory_record));
+        // Cut the preallocated tail so the file holds whole records only
+        if (ftruncate(_fd, _written * sizeof(trajectory_record)) != 0) {}
+        close(_fd);
+    }
+
+    trajectory_log(const trajectory_log&) = delete;
+    trajectory_log& operator=(const trajectory_log&) = delete;
+
+    // Frame loop side: never blocks. Returns false (and counts a drop) if the
+    // writer has fallen a whole queue behind.
+    bool push(const trajectory_record& r)
+    {
+        size_t head = _head.load(std::memory_order_relaxed);
+        if (head - _tail.load(std::memory_order_acquire) == _queue.size())
+        {
+            _dropped++;
+            return false;
+        }
+        _queue[head % _queue.size()] = r;
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    unsigned long long dropped() const { return _dropped; }
+    // Records lost because the file could not grow; non-zero means logging stopped
+    unsigned long long failed() const { return _failed; }
+
+private:
+    // The old mapping stays valid until the new one exists, so a failure
+    // leaves everything written so far in place.
+    void remap(size_t records)
+    {
+        if (ftruncate(_fd, records * sizeof(trajectory_record)) != 0)
+            throw std::runtime_error("cannot grow trajectory log");
+
+        void* mem = mmap(nullptr, records * sizeof(trajectory_record), PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+        if (mem == MAP_FAILED) throw std::runtime_error("cannot map trajectory log");
+
+        if (_map) munmap(_map, _mapped * sizeof(trajectory_record));
+        _map = static_cast<trajectory_record*>(mem);
+        _mapped = records;
+    }
+
+    void write_loop()
+    {
+        while (true)
+        {
+            bool stopping = !_running;
+            size_t tail = _tail.load(std::memory_order_relaxed);
+            size_t head = _head.load(std::memory_order_acquire);
+
+            for (; tail < head; tail++)
+            {
+                if (!_stopped && _written == _mapped)
+                {
+                    try
+                    {
+                        remap(_mapped * 2);
+                    }
+                    catch (const std::exception&)
+                    {
+                        // Disk full or similar: stop writing, but keep
+                        // draining the queue so push() never blocks
+                        _stopped = true;
+                    }
+                }
+
+                if (_stopped) _failed++;
+                else _map[_written++] = _queue[tail % _queue.size()];
+            }
+            _tail.store(tail, std::memory_order_release);
+
+            if (stopping) break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+
+    std::vector<trajectory_record> _queue;
+    std::atomic<size_t> _head{ 0 };
+    std::atomic<size_t> _tail{ 0 };
+    std::atomic<unsigned long long> _dropped{ 0 };
+    std::atomic<unsigned long long> _failed{ 0 };
+    std::atomic<bool> _running{ true };
+
+    int _fd = -1;
+    trajectory_record* _map = nullptr;
+    size_t _mapped = 0;
+    size_t _written = 0;
+    bool _stopped = false;          // writer thread only
+    std::thread _writer;
+};
@@ -0,0 +1,126 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "trajectory-store.hpp"
+
+// Checks trajectory_store and trajectory_log without a camera: time-range
+// queries, floor-grid neighbour queries, ring wrap-around with grid pruning,
+// and appending to an existing log file. Exits with failure if any check
+// does not hold.
+
+static int failures = 0;
+
+static void check(bool ok, const char* what)
+{
+    printf("%s  %s\n", ok ? "ok  " : "FAIL", what);
+    if (!ok) failures++;
+}
+
+static trajectory_record make_record(int id, double t, float x, float z)
+{
+    trajectory_record r = {};
+    r.timestamp = t;
+    r.id = id;
+    r.position[0] = x;
+    r.position[2] = z;
+    r.confidence = 1.f;
+    return r;
+}
+
+int main()
+{
+    // Two targets walking along x, 1 m apart in z, one record every 10 ms
+    {
+        trajectory_store store(64, 0.5f);
+        for (int i = 0; i < 50; i++)
+        {
+            store.append(make_record(1, i * 10.0, i * 0.1f, 2.f));
+            store.append(make_record(2, i * 10.0, i * 0.1f, 3.f));
+        }
+
+        std::vector<trajectory_record> out;
+        store.query(1, 100, 200, out);
+        check(out.size() == 11 && out.front().timestamp == 100 && out.back().timestamp == 200,
+            "query returns the inclusive time range, oldest first");
+
+        store.query(1, 1000, 2000, out);
+        check(out.empty(), "query after the last record is empty");
+        store.query(7, 0, 1000, out);
+        check(out.empty(), "query of an unknown target is empty");
+
+        check(!store.append(make_record(1, 5, 0, 0)), "out-of-order append is rejected");
+
+        trajectory_record last;
+        check(store.latest(1, last) && last.timestamp == 490, "latest is the newest record");
+
+        // Target 1 passes x = 1.0 at t = 100 ms, target 2 is 1 m further away
+        auto ids = store.near(1.0f, 2.f, 0.3f, 50, 150);
+        check(ids.size() == 1 && ids[0] == 1, "near finds the target inside the radius");
+        ids = store.near(1.0f, 2.5f, 0.6f, 50, 150);
+        check(ids.size() == 2, "near finds both targets with a larger radius");
+        ids = store.near(1.0f, 2.f, 0.3f, 300, 400);
+        check(ids.empty(), "near respects the time window");
+    }
+
+    // A ring of 16 records, wrapped many times; pruning runs every 4096 appends
+    {
+        trajectory_store store(16, 0.5f);
+        const int n = 10000;
+        for (int i = 0; i < n; i++)
+            store.append(make_record(3, i, (i / 1000) * 2.f, 0.f));
+
+        std::vector<trajectory_record> out;
+        store.query(3, 0, n, out);
+        check(out.size() == 16 && out.front().timestamp == n - 16 && out.back().timestamp == n - 1,
+            "wrapped ring keeps the newest capacity records in order");
+
+        store.query(3, n - 20, n - 10, out);
+        check(out.size() == 7 && out.front().timestamp == n - 16, "query across the wrapped start");
+
+        // Ten cells visited; the pruning at 8192 appends dropped every visit
+        // that ended before the oldest record then (t = 8176)
+        check(store.visits() == 2, "pruning drops visits older than the ring");
+
+        // The target left x = 0 after t = 999: those records are gone
+        check(store.near(0.f, 0.f, 0.3f, 0, n).empty(), "near ignores visits whose records were overwritten");
+        auto ids = store.near(18.f, 0.f, 0.3f, n - 16, n);
+        check(ids.size() == 1 && ids[0] == 3, "near still finds the current cell");
+    }
+
+    // The log appends to an existing file instead of truncating it
+    {
+        char path[] = "/tmp/trajectory_check_XXXXXX";
+        int fd = mkstemp(path);
+        if (fd < 0)
+        {
+            perror("mkstemp");
+            return EXIT_FAILURE;
+        }
+        close(fd);
+
+        char flag[] = "--trajectory-log";
+        char* argv[] = { flag, flag, path };
+        check(trajectory_log_path(3, argv) == path, "--trajectory-log selects the log path");
+
+        for (int run = 0; run < 2; run++)
+        {
+            trajectory_log log(trajectory_log_path(3, argv));
+            for (int i = 0; i < 100; i++)
+                log.push(make_record(run, i, 0, 0));
+        }
+
+        struct stat st;
+        stat(path, &st);
+        check(st.st_size == 200 * (off_t)sizeof(trajectory_record), "second log run appends to the first");
+        check(trajectory_log_path(1, argv).compare(0, 11, "trajectory-") == 0, "default log path is timestamped");
+        unlink(path);
+    }
+
+    printf("%s\n", failures ? "FAIL" : "PASS");
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}